@@ -0,0 +1,28 @@
+#!/bin/sh
+# Time the build of the multi-TU benchmark binary in the three build modes:
+# header-only runtime, runtime compiled in the library, and library + precompiled header.
+# Usage: run.sh [number of test TUs] [parallel jobs]
+
+set -e
+
+TUS=${1:-200}
+JOBS=${2:-$(nproc 2>/dev/null || echo 1)}
+SOURCE_DIR=$(cd "$(dirname "$0")/../.." && pwd)
+WORK_DIR=${WORK_DIR:-$(mktemp -d)}
+
+run_mode() {
+    name=$1
+    shift
+    build_dir="$WORK_DIR/$name"
+    cmake -S "$SOURCE_DIR" -B "$build_dir" -DCMAKE_BUILD_TYPE=Release \
+        -DH2OFT_BUILD_TIME_BENCHMARK=ON -DH2OFT_BUILD_TIME_BENCHMARK_TUS="$TUS" "$@" > /dev/null
+    start=$(date +%s.%N)
+    cmake --build "$build_dir" --target BuildTimeBenchmark -j "$JOBS" > /dev/null
+    end=$(date +%s.%N)
+    "$build_dir/benchmarks/build_time/BuildTimeBenchmark" > /dev/null
+    awk -v name="$name" -v start="$start" -v end="$end" -v tus="$TUS" 'BEGIN { printf "%s: %.1f s for %d TUs\n", name, end - start, tus }'
+}
+
+run_mode header-only -DH2OFT_SEPARATE_COMPILATION=OFF -DH2OFT_USE_PCH=OFF
+run_mode library -DH2OFT_SEPARATE_COMPILATION=ON -DH2OFT_USE_PCH=OFF
+run_mode library+pch -DH2OFT_SEPARATE_COMPILATION=ON -DH2OFT_USE_PCH=ON
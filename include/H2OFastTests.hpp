@@ -14,22 +14,51 @@
 #define H2OFASTTESTS_H
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
 #include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <random>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <typeinfo>
 #include <typeindex>
 
 #include "H2OFastTests_config.hpp"
 
+#if H2OFT_HAS_COROUTINES
+#include <coroutine>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h> // _ReadWriteBarrier
+#endif
+
 namespace H2OFastTests {
     // Implementation details
     namespace detail {
@@ -38,7 +67,11 @@ namespace H2OFastTests {
         struct type_helper {
             using type = Type;
             static bool before(const std::type_info& rhs) { return typeid(Type).before(rhs); }
+#ifdef _MSC_VER
             static const char* raw_name() { return typeid(Type).raw_name(); }
+#else
+            static const char* raw_name() { return typeid(Type).name(); }
+#endif
             static const char* name() { return typeid(Type).name(); }
             static size_t hash_code() { return typeid(Type).hash_code(); }
             static std::type_index type_index() { return std::type_index(typeid(Type)); }
@@ -96,7 +129,8 @@ namespace H2OFastTests {
         enum class FailureType {
             equal,
             different,
-            exception
+            exception,
+            matches
         };
 
         template<bool Streamable, bool Exception>
@@ -120,6 +154,10 @@ namespace H2OFastTests {
                     oss << "\t\t\t[EXPECTED DIFFERENT FROM] " << expected << std::endl;
                     break;
                 }
+                case FailureType::matches: {
+                    oss << "\t\t\t[EXPECTED TO MATCH] " << expected << std::endl;
+                    break;
+                }
                 case FailureType::exception:
                 default: {
                     oss << "\t\t\t[ERROR] " << std::endl;
@@ -144,6 +182,10 @@ namespace H2OFastTests {
                     oss << "\t\t\t[REACHED] is equal to [EXPECTED]. Expected [DIFFERENT FROM]" << std::endl;
                     break;
                 }
+                case FailureType::matches: {
+                    oss << "\t\t\t[REACHED] doesn't match [EXPECTED]" << std::endl;
+                    break;
+                }
                 case FailureType::exception:
                 default: {
                     oss << "\t\t\t[ERROR] " << std::endl;
@@ -166,6 +208,7 @@ namespace H2OFastTests {
                 }
                 case FailureType::equal:
                 case FailureType::different:
+                case FailureType::matches:
                 default: {
                     oss << "\t\t\t[ERROR] " << std::endl;
                     break;
@@ -205,6 +248,25 @@ namespace H2OFastTests {
 
         };
 
+        class Test;
+
+        // Test being run by the calling thread, nullptr outside of a test
+        H2OFT_NO_INSTRUMENT inline Test*& current_test() {
+            static thread_local Test* test = nullptr;
+            return test;
+        }
+
+        // Report a failure raised on a thread not owned by a test (e.g. a raw std::thread started by the test body)
+        // to the test being run, or as unowned (get_unowned_failures()) if several tests are running
+        // An unowned failure fails the scenarios running when it was raised (ScenarioRegistry::getUnownedFailures())
+        // and counts for Options::fail_fast
+        // Returns false if no test is running. Otherwise the assertion doesn't throw, as it would terminate the program :
+        // unlike on a test thread, the code following the failed assertion keeps running
+        H2OFT_DECL bool report_unowned_failure(const std::string& message);
+
+        // Failures raised on threads without test that couldn't be attributed to a single running test
+        H2OFT_DECL std::vector<std::string> get_unowned_failures();
+
         // Internal impl for processing an assert and raise the TestFailure Exception
         template<class ValueTypeL, class ValueTypeR, class ExceptionType = void,
             typename = std::enable_if_t<
@@ -220,10 +282,317 @@ namespace H2OFastTests {
                     oss << message;
                 }
 
-                throw TestFailure<ValueTypeL, ValueTypeR, ExceptionType>(oss.str(), reached, expected, failure_type);
+                TestFailure<ValueTypeL, ValueTypeR, ExceptionType> failure(oss.str(), reached, expected, failure_type);
+                // Throwing out of a thread without test would terminate the program
+                if (current_test() == nullptr && report_unowned_failure(failure.what()))
+                    return;
+                throw failure;
+            }
+        }
+
+#if defined(H2OFT_SEPARATE_COMPILATION)
+        // Assertions on the common types are instantiated once in the H2OFastTests library
+        extern template void FailureTest<bool, bool>(bool, bool, bool, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<int, int>(bool, int, int, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<unsigned int, unsigned int>(bool, unsigned int, unsigned int, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<long, long>(bool, long, long, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<unsigned long, unsigned long>(bool, unsigned long, unsigned long, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<long long, long long>(bool, long long, long long, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<unsigned long long, unsigned long long>(bool, unsigned long long, unsigned long long, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<float, float>(bool, float, float, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<double, double>(bool, double, double, FailureType, const std::string&, const LineInfo&);
+        extern template void FailureTest<std::string, std::string>(bool, std::string, std::string, FailureType, const std::string&, const LineInfo&);
+#endif
+
+        // Result of the comparison of a buffer with a snapshot (golden) file
+        struct SnapshotComparison {
+            bool matches = false;
+            std::string summary;  // Where the buffer and the snapshot differ
+            std::string reached;  // Hex/text window of the buffer around the first difference
+            std::string expected; // Same window in the snapshot
+        };
+
+        // Compare a buffer with a snapshot file mapped in memory and compared by chunks (never read in a std::string)
+        // The hash saved by write_snapshot lets a matching buffer pass without reading the file at all
+        H2OFT_DECL SnapshotComparison compare_snapshot(const char* data, size_t size, const std::string& path);
+
+        // Atomically replace the snapshot file (and its hash) by the buffer, returns false on I/O error
+        H2OFT_DECL bool write_snapshot(const char* data, size_t size, const std::string& path);
+
+        // compare_snapshot, or write_snapshot when Options::update_snapshots is set
+        H2OFT_DECL SnapshotComparison match_snapshot(const char* data, size_t size, const std::string& path);
+
+        // Bytes of a buffer compared with a snapshot : strings or contiguous containers of trivially copyable values
+        template<class Buffer>
+        std::pair<const char*, size_t> snapshot_bytes(const Buffer& buffer) {
+            if constexpr (std::is_convertible_v<const Buffer&, std::string_view>) {
+                const std::string_view view = buffer;
+                return{ view.data(), view.size() };
+            }
+            else {
+                using Value = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(buffer))>>;
+                static_assert(std::is_trivially_copyable_v<Value>, "A snapshot compares the bytes of trivially copyable values");
+                return{ reinterpret_cast<const char*>(std::data(buffer)), std::size(buffer) * sizeof(Value) };
+            }
+        }
+
+        // Matchers checked by AssertThat(x).matches(matcher) : match() is inlined, describe() is only called to format a failure
+        struct MatcherBase {};
+
+        template<class T>
+        constexpr bool is_matcher_v = std::is_base_of_v<MatcherBase, std::decay_t<T>>;
+
+        template<class T>
+        void describe_value(std::ostream& os, const T& value) {
+            if constexpr (is_streamable<std::stringstream, T>::value) {
+                os << value;
+            }
+            else {
+                os << "[" << type_helper<T>::name() << "]";
+            }
+        }
+
+        template<class T>
+        struct EqualToMatcher : MatcherBase {
+            T expected;
+
+            template<class Value>
+            bool match(const Value& value) const { return value == expected; }
+            void describe(std::ostream& os) const {
+                os << "equal to ";
+                describe_value(os, expected);
+            }
+        };
+
+        template<class T>
+        EqualToMatcher<std::decay_t<T>> equalTo(T&& expected) { return{ {}, std::forward<T>(expected) }; }
+
+        // Matchers given to the combinators, plain values being compared with operator ==
+        template<class T>
+        auto as_matcher(T&& value) {
+            if constexpr (is_matcher_v<T>) {
+                return std::decay_t<T>{ std::forward<T>(value) };
+            }
+            else {
+                return equalTo(std::forward<T>(value));
+            }
+        }
+
+        // Descriptions of the matchers of a tuple, separated by commas
+        template<class Tuple>
+        void describe_list(std::ostream& os, const Tuple& matchers) {
+            size_t index = 0;
+            std::apply([&](const auto&... matcher) {
+                ((os << (index++ == 0 ? "" : ", "), matcher.describe(os)), ...);
+            }, matchers);
+        }
+
+        template<class... Matchers>
+        struct AllOfMatcher : MatcherBase {
+            std::tuple<Matchers...> matchers;
+
+            template<class Value>
+            bool match(const Value& value) const {
+                return std::apply([&value](const auto&... matcher) { return (matcher.match(value) && ...); }, matchers);
+            }
+            void describe(std::ostream& os) const {
+                os << "all of (";
+                describe_list(os, matchers);
+                os << ")";
+            }
+        };
+
+        template<class... Matchers>
+        struct AnyOfMatcher : MatcherBase {
+            std::tuple<Matchers...> matchers;
+
+            template<class Value>
+            bool match(const Value& value) const {
+                return std::apply([&value](const auto&... matcher) { return (matcher.match(value) || ...); }, matchers);
+            }
+            void describe(std::ostream& os) const {
+                os << "any of (";
+                describe_list(os, matchers);
+                os << ")";
+            }
+        };
+
+        template<class... Matchers>
+        auto allOf(Matchers&&... matchers) {
+            return AllOfMatcher<decltype(as_matcher(std::forward<Matchers>(matchers)))...>{ {}, { as_matcher(std::forward<Matchers>(matchers))... } };
+        }
+
+        template<class... Matchers>
+        auto anyOf(Matchers&&... matchers) {
+            return AnyOfMatcher<decltype(as_matcher(std::forward<Matchers>(matchers)))...>{ {}, { as_matcher(std::forward<Matchers>(matchers))... } };
+        }
+
+        template<class Matcher>
+        struct NotMatcher : MatcherBase {
+            Matcher matcher;
+
+            template<class Value>
+            bool match(const Value& value) const { return !matcher.match(value); }
+            void describe(std::ostream& os) const {
+                os << "not ";
+                matcher.describe(os);
+            }
+        };
+
+        template<class Matcher>
+        auto not_(Matcher&& matcher) {
+            return NotMatcher<decltype(as_matcher(std::forward<Matcher>(matcher)))>{ {}, as_matcher(std::forward<Matcher>(matcher)) };
+        }
+
+        // Bounds included
+        template<class T>
+        struct InRangeMatcher : MatcherBase {
+            T low;
+            T high;
+
+            template<class Value>
+            bool match(const Value& value) const { return !(value < low) && !(high < value); }
+            void describe(std::ostream& os) const {
+                os << "in range [";
+                describe_value(os, low);
+                os << ", ";
+                describe_value(os, high);
+                os << "]";
+            }
+        };
+
+        template<class Low, class High>
+        auto inRange(const Low& low, const High& high) {
+            using T = std::common_type_t<std::decay_t<Low>, std::decay_t<High>>;
+            return InRangeMatcher<T>{ {}, static_cast<T>(low), static_cast<T>(high) };
+        }
+
+        template<class T>
+        struct NearMatcher : MatcherBase {
+            T expected;
+            T tolerance;
+
+            template<class Value>
+            bool match(const Value& value) const { return std::abs(value - expected) <= std::abs(tolerance); }
+            void describe(std::ostream& os) const {
+                os << "near ";
+                describe_value(os, expected);
+                os << " +/- ";
+                describe_value(os, tolerance);
+            }
+        };
+
+        template<class Expected, class Tolerance>
+        auto near(const Expected& expected, const Tolerance& tolerance) {
+            using T = std::common_type_t<Expected, Tolerance>;
+            return NearMatcher<T>{ {}, static_cast<T>(expected), static_cast<T>(tolerance) };
+        }
+
+        // Size of a container or a string, compared with a size or matched by a matcher
+        template<class Matcher>
+        struct HasSizeMatcher : MatcherBase {
+            Matcher matcher;
+
+            template<class Value>
+            bool match(const Value& value) const { return matcher.match(static_cast<size_t>(std::size(value))); }
+            void describe(std::ostream& os) const {
+                os << "size ";
+                matcher.describe(os);
+            }
+        };
+
+        template<class Matcher>
+        auto hasSize(Matcher&& matcher) {
+            if constexpr (is_matcher_v<Matcher>) {
+                return HasSizeMatcher<std::decay_t<Matcher>>{ {}, std::forward<Matcher>(matcher) };
+            }
+            else {
+                return HasSizeMatcher<EqualToMatcher<size_t>>{ {}, equalTo(static_cast<size_t>(matcher)) };
+            }
+        }
+
+        // A range with an element matched by a matcher, Plain when it was given a value compared with operator ==
+        template<class Matcher, bool Plain = false>
+        struct ContainsMatcher : MatcherBase {
+            Matcher matcher;
+
+            template<class Value>
+            bool match(const Value& value) const {
+                for (const auto& element : value) {
+                    if (matcher.match(element))
+                        return true;
+                }
+                return false;
+            }
+            void describe(std::ostream& os) const {
+                os << "contains ";
+                if constexpr (Plain) {
+                    describe_value(os, matcher.expected);
+                }
+                else {
+                    matcher.describe(os);
+                }
+            }
+        };
+
+        // A string containing a substring, or a range with an element equal to it
+        // Text is a std::string_view for a literal or a const char*, an owning std::string otherwise
+        template<class Text>
+        struct ContainsTextMatcher : MatcherBase {
+            Text text;
+
+            template<class Value>
+            bool match(const Value& value) const {
+                if constexpr (std::is_convertible_v<const Value&, std::string_view>) {
+                    return std::string_view{ value }.find(text) != std::string_view::npos;
+                }
+                else {
+                    for (const auto& element : value) {
+                        if (element == text)
+                            return true;
+                    }
+                    return false;
+                }
+            }
+            void describe(std::ostream& os) const {
+                os << "contains ";
+                describe_value(os, text);
+            }
+        };
+
+        template<class Matcher>
+        auto contains(Matcher&& matcher) {
+            if constexpr (is_matcher_v<Matcher>) {
+                return ContainsMatcher<std::decay_t<Matcher>>{ {}, std::forward<Matcher>(matcher) };
+            }
+            else if constexpr (std::is_convertible_v<const Matcher&, std::string_view>) {
+                if constexpr (std::is_pointer_v<std::decay_t<Matcher>>) {
+                    return ContainsTextMatcher<std::string_view>{ {}, std::string_view{ matcher } };
+                }
+                else {
+                    return ContainsTextMatcher<std::string>{ {}, std::string{ std::string_view{ matcher } } };
+                }
+            }
+            else {
+                return ContainsMatcher<EqualToMatcher<std::decay_t<Matcher>>, true>{ {}, equalTo(std::forward<Matcher>(matcher)) };
             }
         }
 
+        template<class Predicate>
+        struct PredicateMatcher : MatcherBase {
+            Predicate predicate;
+            const char* description;
+
+            template<class Value>
+            bool match(const Value& value) const { return static_cast<bool>(predicate(value)); }
+            void describe(std::ostream& os) const { os << description; }
+        };
+
+        template<class Predicate>
+        PredicateMatcher<std::decay_t<Predicate>> matchesPredicate(Predicate&& predicate, const char* description = "the predicate") {
+            return{ {}, std::forward<Predicate>(predicate), description };
+        }
+
         // Assert test class to help verbosing test logic into lambda's impl
         template<class Expr>
         class AsserterExpression {
@@ -309,6 +678,31 @@ namespace H2OFastTests {
                 return fail_exception<ExpectedException>(message, lineInfo);
             }
 
+            // Compare a contiguous buffer (std::string, std::vector<uint8_t>...) with a snapshot file
+            // Options::update_snapshots rewrites the snapshot with the buffer instead
+            EmptyExpression matchesSnapshot(const std::string& path,
+                const std::string& message = {}, const LineInfo& lineInfo = {}) {
+                const auto bytes = snapshot_bytes(expr_);
+                const auto comparison = match_snapshot(bytes.first, bytes.second, path);
+                FailureTest(comparison.matches, comparison.reached, comparison.expected, FailureType::equal,
+                    message.empty() ? comparison.summary : message + " " + comparison.summary, lineInfo);
+                return{};
+            }
+
+            // Verify that the value matches the matcher (allOf, anyOf, not_, inRange, hasSize, contains, matchesPredicate, near...)
+            template<class Matcher, typename = std::enable_if_t<is_matcher_v<Matcher>>>
+            EmptyExpression matches(const Matcher& matcher,
+                const std::string& message = {}, const LineInfo& lineInfo = {}) {
+                if (!matcher.match(expr_)) {
+                    std::ostringstream reached;
+                    std::ostringstream expected;
+                    describe_value(reached, expr_);
+                    matcher.describe(expected);
+                    FailureTest(false, reached.str(), expected.str(), FailureType::matches, message, lineInfo);
+                }
+                return{};
+            }
+
             // Invoque operator == on T
             template<class T>
             EmptyExpression isEqualTo(const T& expected,
@@ -435,196 +829,2822 @@ namespace H2OFastTests {
         using TearDownFunctor = std::function<void(void)>;
         using Duration = std::chrono::duration<double, std::milli>; // ms
 
-        // Standard class discribing a test
-        class Test {
+        // Log-linear latency histogram (HdrHistogram-like) with a fixed memory footprint
+        // Values are in ns : exact below 128 ns, then each power of 2 is split into 64 sub-buckets (< 1.6% error)
+        // Recording is O(1) and never allocates, histograms of several workers can be merged
+        class Histogram {
         public:
 
-            // States of the test
-            enum class Status {
-                PASSED,    // test successfuly passed
-                FAILED,    // test failed to pass (an assert failed)
-                ERROR,    // an error occured during the test :
-                // any exception was catched like bad_alloc
-                SKIPPED,// test was skipped and not run
-                NONE    // the run_scenario function wasn't run yet
-                // for the scenario holding the test
-            };
-
-            // All available constructors
-            Test()
-                : Test({}, []() {}) {}
-            Test(const TestFunctor&& test)
-                : Test("", std::move(test)) {}
-            Test(const std::string& label)
-                : Test(label, []() {}) {}
-            Test(const std::string& label, const TestFunctor&& test)
-                : test_holder_(std::make_unique<TestFunctor>(std::move(test))), label_(label), status_(Status::NONE)
-            {}
-
-            // Copy forbidden
-            Test(const Test&) = delete;
-            Test& operator=(const Test&) = delete;
+            Histogram() { reset(); }
 
-            // Default move impl (for VC2013)
-            Test(Test&& test)
-                : exec_time_ms_(test.exec_time_ms_),
-                test_holder_(std::move(test.test_holder_)), label_(test.label_),
-                failure_reason_(test.failure_reason_), skipped_reason_(test.skipped_reason_),
-                error_(test.error_), status_(test.status_)
-            {}
-            Test&& operator=(Test&& test) {
-                test_holder_ = std::move(test.test_holder_);
-                label_ = test.label_;
-                status_ = test.status_;
-                exec_time_ms_ = test.exec_time_ms_;
-                failure_reason_ = test.failure_reason_;
-                skipped_reason_ = test.skipped_reason_;
-                error_ = test.error_;
-                return std::move(*this);
+            void reset() {
+                counts_.fill(0);
+                total_count_ = 0;
+                total_ = 0.;
+                min_ = std::numeric_limits<uint64_t>::max();
+                max_ = 0;
             }
 
-            Test(std::reference_wrapper<Test> test)
-                : Test(std::move(test.get()))
-            {}
+            // Record a value in ns
+            void recordValue(uint64_t value, uint64_t count = 1) {
+                counts_[index_of(value)] += count;
+                total_count_ += count;
+                total_ += static_cast<double>(value) * static_cast<double>(count);
+                min_ = std::min(min_, value);
+                max_ = std::max(max_, value);
+            }
 
-            // Virtual destructor impl
-            virtual ~Test() {}
+            void record(Duration duration) {
+                recordValue(static_cast<uint64_t>(std::max(0., duration.count()) * 1e6));
+            }
 
-            // Information getters
-            const std::string& getLabel(bool verbose) const { return getLabel_private(verbose); }
-            const std::string& getFailureReason() const { return getFailureReason_private(); }
-            const std::string& getSkippedReason() const { return getSkippedReason_private(); }
-            const std::string& getError() const { return getError_private(); }
-            Duration getExecTimeMs() const { return getExecTimeMs_private(); }
-            Status getStatus() const { return getStatus_private(); }
+            void merge(const Histogram& other) {
+                for (size_t index = 0; index < bucket_count; ++index) {
+                    counts_[index] += other.counts_[index];
+                }
+                total_count_ += other.total_count_;
+                total_ += other.total_;
+                min_ = std::min(min_, other.min_);
+                max_ = std::max(max_, other.max_);
+            }
 
-        protected:
+            uint64_t getTotalCount() const { return total_count_; }
+            Duration getMin() const { return to_duration(total_count_ > 0 ? min_ : 0); }
+            Duration getMax() const { return to_duration(max_); }
+            Duration getMean() const { return Duration{ total_count_ > 0 ? total_ / static_cast<double>(total_count_) / 1e6 : 0. }; }
+
+            // Smallest recorded value such that percentile % of the values are lower or equal
+            Duration getValueAtPercentile(double percentile) const {
+                if (total_count_ == 0)
+                    return Duration{ 0 };
+                const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100. * static_cast<double>(total_count_))));
+                uint64_t count = 0;
+                for (size_t index = 0; index < bucket_count; ++index) {
+                    count += counts_[index];
+                    if (count >= target) {
+                        return to_duration(std::min(std::max(highest_equivalent_value(index), min_), max_));
+                    }
+                }
+                return to_duration(max_);
+            }
 
-            // Called by RegistryManager
-            void run(const SetUpFunctor& setup, const TearDownFunctor& teardown) {
-                setup();
-                run_private();
-                teardown();
+            // p50/p90/p99/p99.9/max in ms
+            std::string getSummary() const {
+                std::ostringstream oss;
+                oss << "p50 " << getValueAtPercentile(50.).count() << " ms, p90 " << getValueAtPercentile(90.).count()
+                    << " ms, p99 " << getValueAtPercentile(99.).count() << " ms, p99.9 " << getValueAtPercentile(99.9).count()
+                    << " ms, max " << getMax().count() << " ms (" << total_count_ << " values)";
+                return oss.str();
             }
 
-            // Run the test and capture and set the state
-            virtual void run_private() {
-                auto start = std::chrono::high_resolution_clock::now();
-                try {
-                    (*test_holder_)(); /* /!\ Here is the test call /!\ */
-                    status_ = Status::PASSED;
-                }
-                catch (const GenericTestFailure& failure) {
-                    status_ = Status::FAILED;
-                    failure_reason_ = failure.what();
-                }
-                catch (const std::exception& e) {
-                    status_ = Status::ERROR;
-                    error_ = e.what();
+            // Mergeable text export : only non empty buckets are written
+            void save(std::ostream& os) const {
+                os << file_header() << ' ' << sub_bucket_bits << ' ' << total_count_ << ' ' << min_ << ' ' << max_ << '\n';
+                for (size_t index = 0; index < bucket_count; ++index) {
+                    if (counts_[index] > 0) {
+                        os << index << ' ' << counts_[index] << '\n';
+                    }
                 }
-                catch (...) {
-                    status_ = Status::ERROR;
-                    error_ = "Unkown error";
+                os << "end\n";
+            }
+
+            // Merge a histogram exported by save() into this one, false if the input is malformed
+            bool load(std::istream& is) {
+                std::string header, version;
+                uint64_t bits = 0, total_count = 0, min = 0, max = 0;
+                if (!(is >> header >> version >> bits >> total_count >> min >> max) || header + ' ' + version != file_header() || bits != sub_bucket_bits)
+                    return false;
+                Histogram other;
+                std::string token;
+                while (is >> token && token != "end") {
+                    uint64_t count = 0;
+                    size_t index = 0;
+                    try {
+                        size_t parsed = 0;
+                        index = static_cast<size_t>(std::stoull(token, &parsed));
+                        if (parsed != token.size())
+                            return false;
+                    }
+                    catch (const std::logic_error&) { // std::invalid_argument or std::out_of_range
+                        return false;
+                    }
+                    if (!(is >> count) || index >= bucket_count)
+                        return false;
+                    other.counts_[index] = count;
+                    other.total_ += static_cast<double>(highest_equivalent_value(index)) * static_cast<double>(count);
                 }
-                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+                other.total_count_ = total_count;
+                other.min_ = min;
+                other.max_ = max;
+                merge(other);
+                return token == "end";
             }
 
-            // Informations getters impl
-            virtual const std::string& getLabel_private(bool /*verbose*/) const { return label_; }
-            virtual const std::string& getFailureReason_private() const { return failure_reason_; }
-            virtual const std::string& getSkippedReason_private() const { return skipped_reason_; }
-            virtual const std::string& getError_private() const { return error_; }
-            virtual Duration getExecTimeMs_private() const { return exec_time_ms_; }
-            virtual Status getStatus_private() const { return status_; }
+        private:
 
-        protected:
+            static const uint64_t sub_bucket_bits = 7;
+            static const uint64_t sub_bucket_count = uint64_t{ 1 } << sub_bucket_bits;
+            static const uint64_t sub_bucket_half = sub_bucket_count / 2;
+            static const size_t bucket_count = static_cast<size_t>(sub_bucket_count + (64 - sub_bucket_bits) * sub_bucket_half);
 
-            Duration exec_time_ms_;
-            std::unique_ptr<TestFunctor> test_holder_;
-            std::string label_;
-            std::string failure_reason_;
-            std::string skipped_reason_;
-            std::string error_;
-            Status status_;
+            static const char* file_header() { return "H2OFastTests-histogram v1"; }
 
-            template<class ScenarioName>
-            friend class RegistryManager;
-        };
-
-        std::ostream& operator<<(std::ostream& os, Test::Status status) {
-            switch (status) {
-            case Test::Status::PASSED:
-                os << "PASSED";
-                break;
-            case Test::Status::FAILED:
-                os << "FAILED";
-                break;
-            case Test::Status::ERROR:
-                os << "ERROR";
-                break;
-            case Test::Status::SKIPPED:
-                os << "SKIPPED";
-                break;
-            case Test::Status::NONE:
-            default:
-                os << "NOT RUN YET";
-                break;
-            }
-            return os;
-        }
+            static Duration to_duration(uint64_t value) { return Duration{ static_cast<double>(value) / 1e6 }; }
 
-        std::string to_string(Test::Status status) {
-            std::ostringstream os;
-            os << status;
-            return os.str();
-        }
+            static uint64_t log2_floor(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+                return 63 - static_cast<uint64_t>(__builtin_clzll(value));
+#else
+                uint64_t result = 0;
+                while (value >>= 1) ++result;
+                return result;
+#endif
+            }
 
-        // This class wrap a test and make it so it's skipped (never run)
-        class SkippedTest : public Test {
-        public:
+            static size_t index_of(uint64_t value) {
+                if (value < sub_bucket_count)
+                    return static_cast<size_t>(value);
+                const auto exponent = log2_floor(value);
+                const auto shift = exponent - sub_bucket_bits + 1;
+                return static_cast<size_t>(sub_bucket_count + (exponent - sub_bucket_bits) * sub_bucket_half + ((value >> shift) - sub_bucket_half));
+            }
 
-            SkippedTest(TestFunctor&& func)
-                : Test{ std::move(func) } {}
-            SkippedTest(const std::string& label, TestFunctor&& func)
-                : Test{ label, std::move(func) } {}
-            SkippedTest(const std::string& reason, const std::string& label, TestFunctor&& func)
-                : SkippedTest{ label, std::move(func) }
-            {
-                skipped_reason_ = reason;
+            static uint64_t highest_equivalent_value(size_t index) {
+                if (index < sub_bucket_count)
+                    return index;
+                const auto offset = index - sub_bucket_count;
+                const auto shift = offset / sub_bucket_half + 1;
+                const auto sub_bucket = sub_bucket_half + offset % sub_bucket_half;
+                return ((sub_bucket + 1) << shift) - 1;
             }
 
-        protected:
+            std::array<uint64_t, bucket_count> counts_;
+            uint64_t total_count_;
+            double total_;
+            uint64_t min_;
+            uint64_t max_;
+        };
 
-            // Put state to skipped and don't run the test
-            virtual void run_private() override { status_ = Test::Status::SKIPPED; }
+        // Global options of the test runner
+        struct Options {
+            // Snapshot the OS resource usage of the thread around each test (Linux only)
+            bool collect_resource_usage = false;
+            // Seed of the shuffle and of the tests randomness, 0 draws a random seed at the first run
+            uint64_t seed = 0;
+            // Run the tests of a scenario in a random order drawn from the seed
+            bool shuffle = false;
+            // Run each test repeat times, from first_iteration (to replay a reported iteration)
+            size_t repeat = 1;
+            size_t first_iteration = 0;
+            // Stop repeating a test at its first failure
+            bool until_fail = false;
+            // Number of threads running the repeats of a test, set_up and tear_down must then be thread safe
+            size_t jobs = 1;
+            // Only run the tests whose label contains this string
+            std::string filter;
+            // Number of event loop threads running the async tests of a scenario, set_up and tear_down must then be thread safe
+            size_t async_threads = 1;
+            // Number of scenarios run at once by run_all_scenarios(), 0 for the hardware concurrency
+            // The failures of threads without test can't be attributed while several scenarios run (see report_unowned_failure)
+            size_t scenario_jobs = 1;
+            // Cancel the run after this number of failed tests (FAILED or ERROR), 0 to run everything
+            size_t fail_fast = 0;
+            // matchesSnapshot rewrites the snapshot files with the reached buffers instead of comparing them
+            bool update_snapshots = false;
+            // Fuzz the fuzz tests instead of replaying their corpus, until a budget is spent (0 : no limit)
+            bool fuzz = false;
+            double fuzz_seconds = 10.;
+            size_t fuzz_runs = 0;
+            // Maximum size of the inputs generated by the fuzzer
+            size_t fuzz_max_length = 4096;
+            // Test impact analysis index file, empty to disable it
+            std::string impact_index;
+            // Record the functions run by each test into the index (code under test built with -finstrument-functions)
+            bool impact_record = false;
+            // Only run the tests affected by the changed source files or functions (ImpactIndex::isAffected) and their prerequisites
+            bool impact_select = false;
+            std::vector<std::string> impact_changes;
+            // Publish the live progress of the run in this memory-mapped file (ProgressFile), empty to disable it
+            std::string progress_file;
+            // Record the timeline of the run (scenarios, set_up, test bodies, tear_down and TraceSpan) for save_trace()
+            bool trace = false;
         };
 
-        // Helper functions to build/skip a test case
-        std::unique_ptr<Test> make_test(TestFunctor&& func) { return std::make_unique<Test>(std::move(func)); }
-        std::unique_ptr<Test> make_test(const std::string& label, TestFunctor&& func) { return std::make_unique<Test>(label, std::move(func)); }
-        std::unique_ptr<Test> make_skipped_test(TestFunctor&& test) { return std::make_unique<SkippedTest>(std::move(test)); }
-        std::unique_ptr<Test> make_skipped_test(const std::string& label, TestFunctor&& func) { return std::make_unique<SkippedTest>(label, std::move(func)); }
-        std::unique_ptr<Test> make_skipped_test(const std::string& reason, const std::string& label, TestFunctor&& func) { return std::make_unique<SkippedTest>(reason, label, std::move(func)); }
+        H2OFT_DECL Options& get_options();
 
-        // POD containing informations about a test
-        using TestInfo = std::reference_wrapper<const Test>;
+        // Seed of the run, drawn once if not given by the options
+        H2OFT_DECL uint64_t get_seed();
 
-        // Interface for making an observer
-        class IRegistryObserver {
-        public:
-            virtual void update(TestInfo infos) const = 0;
-        };
+        // Seed of one iteration of a test : the same run seed, label and iteration give the same seed
+        H2OFT_DECL uint64_t iteration_seed(uint64_t seed, const std::string& label, size_t iteration);
 
-        // Implementation of the observable part of the DP observer
-        class IRegistryObservable {
+        // Cooperative cancellation of the run (Options::fail_fast) : no test is started once cancelled
+        // and the running tests can poll is_cancelled() to exit early
+        // It stays cancelled across scenarios until reset
+        class CancellationToken {
         public:
-            void notify(TestInfo infos) const {
-                for (auto& observer : list_observers_) {
-                    observer->update(infos);
+
+            bool isCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+            // The first reason given is kept until reset
+            void cancel(const std::string& reason = "cancelled by the user") {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                if (!cancelled_) {
+                    reason_ = reason;
+                    cancelled_.store(true, std::memory_order_release);
                 }
             }
-            void addObserver(const std::shared_ptr<IRegistryObserver>& observer) { list_observers_.insert(observer); }
-            void removeObserver(const std::shared_ptr<IRegistryObserver>& observer) { list_observers_.erase(observer); }
+            void reset() {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                cancelled_ = false;
+                failures_ = 0;
+                reason_.clear();
+            }
+            std::string getReason() const {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                return reason_;
+            }
+
+            // Count a failed test, cancel the run once threshold failures were counted (never with 0)
+            void addFailure(size_t threshold) {
+                if (++failures_ >= threshold && threshold > 0) {
+                    cancel("fail fast after " + std::to_string(threshold) + " failed tests");
+                }
+            }
+            size_t getFailures() const { return failures_; }
+
+        private:
+
+            mutable std::mutex mutex_;
+            std::atomic<bool> cancelled_{ false };
+            std::atomic<size_t> failures_{ 0 };
+            std::string reason_;
+        };
+
+        H2OFT_DECL CancellationToken& get_cancellation_token();
+
+        inline bool is_cancelled() {
+            return get_cancellation_token().isCancelled();
+        }
+
+        // Functions run by each test (and their source files), kept between runs for the test impact analysis
+        // File : a journal of "F <function>\t<file>" lines, numbered in file order, and "T <scenario>\t<label>\t<function numbers>" lines
+        // The last line of a test replaces its previous ones : a run only appends the tests it recorded (flush())
+        class ImpactIndex {
+        public:
+
+            using Function = std::pair<std::string, std::string>; // Symbol, source file (empty if unknown)
+
+            // Load the index file once per path, an index missing or unreadable is empty
+            // A journal holding more replaced lines than tests is compacted (save())
+            void open(const std::string& path);
+            // Atomically rewrite the index file, one line per test : the functions no longer run by any test are dropped
+            bool save();
+            // Append the tests recorded since the last open(), save() or flush(), with the functions they added
+            bool flush();
+
+            // Replace the functions recorded for a test
+            void record(const std::string& scenario, const std::string& label, const std::vector<Function>& functions);
+            bool isRecorded(const std::string& scenario, const std::string& label) const { return tests_.count(key(scenario, label)) > 0; }
+            // A test is affected if it was never recorded, or if it ran a changed function or a function of a changed source file
+            // A change matches a file by suffix ("src/parser.cpp"), or a function by name ("ns::parse" or "ns::parse(int)")
+            bool isAffected(const std::string& scenario, const std::string& label, const std::vector<std::string>& changes) const;
+            size_t getTestsCount() const { return tests_.size(); }
+            const std::string& getPath() const { return path_; }
+
+        private:
+
+            static std::string key(const std::string& scenario, const std::string& label) { return scenario + '\t' + label; }
+
+            std::string path_;
+            std::vector<Function> functions_;
+            std::map<Function, uint32_t> function_ids_;
+            std::map<std::string, std::vector<uint32_t>> tests_;
+            size_t written_functions_ = 0;       // functions_ already in the file, with the same numbers
+            std::set<std::string> pending_tests_; // recorded, not in the file yet
+            bool rewrite_ = false;                // file numbered differently, to save()
+        };
+
+        // Index of Options::impact_index, guarded by get_impact_mutex() as scenarios may run concurrently
+        H2OFT_DECL ImpactIndex& get_impact_index();
+        H2OFT_DECL std::mutex& get_impact_mutex();
+
+        // Live progress of the run, published in a memory-mapped file (Options::progress_file) that other processes can poll
+        // Fixed layout of lock-free atomics, the names and labels are guarded by a sequence number (odd while written)
+        struct ProgressFile {
+            static constexpr size_t max_scenarios = 256;
+            static constexpr size_t max_workers = 64;
+            static constexpr size_t name_size = 112;
+            static constexpr size_t label_size = 240;
+
+            struct Scenario {
+                std::atomic<uint64_t> sequence;
+                std::atomic<uint64_t> total;
+                std::atomic<uint64_t> done;
+                std::atomic<uint64_t> failed; // FAILED and ERROR
+                char name[name_size];
+            };
+
+            // A thread running tests, label is the running test (empty when idle)
+            struct Worker {
+                std::atomic<uint64_t> taken; // 0 once the thread exited
+                std::atomic<uint64_t> sequence;
+                std::atomic<uint64_t> tests;
+                char label[label_size];
+            };
+
+            char magic[8]; // "H2OFTPRG"
+            uint32_t version;
+            uint32_t pid;
+            std::atomic<uint64_t> start_time_ns; // System clock, since the epoch
+            std::atomic<uint64_t> elapsed_ns;    // Updated when a test starts or ends
+            std::atomic<uint64_t> total;
+            std::atomic<uint64_t> done;
+            std::atomic<uint64_t> passed;
+            std::atomic<uint64_t> failed;
+            std::atomic<uint64_t> errors;
+            std::atomic<uint64_t> skipped;
+            std::atomic<uint64_t> cancelled;
+            std::atomic<uint32_t> scenario_count;
+            std::atomic<uint32_t> worker_count;
+            Scenario scenarios[max_scenarios];
+            Worker workers[max_workers];
+        };
+
+        // Progress file of the run, nullptr unless Options::progress_file is set (Linux with lock-free 64 bits atomics only)
+        H2OFT_DECL std::atomic<ProgressFile*>& get_progress();
+
+        // Map Options::progress_file if it changed since the last call
+        H2OFT_DECL void open_progress(const std::string& path);
+
+        // Report of a progress file, as polled by an external tool (empty if it can't be read)
+        H2OFT_DECL std::string read_progress(const std::string& path);
+
+        // Span of the timeline of the run, in ns since the start of the trace
+        struct TraceEvent {
+            std::string name;
+            const char* category;
+            uint64_t begin_ns;
+            uint64_t end_ns;
+            std::string args; // Members of a JSON object, may be empty
+        };
+
+        // Timeline of the run recorded with Options::trace, saved as a Chrome trace-event JSON file (chrome://tracing, Perfetto UI)
+        // Each thread appends to its own buffer (a track of the timeline), the global lock is only taken by its first span
+        class TraceStorage {
+        public:
+
+            struct Buffer {
+                std::mutex mutex; // Only contended while the trace is saved
+                std::vector<TraceEvent> events;
+                size_t track;
+            };
+
+            void record(TraceEvent&& event) {
+                auto& buffer = getThreadBuffer();
+                std::lock_guard<std::mutex> lock{ buffer.mutex };
+                buffer.events.push_back(std::move(event));
+            }
+
+            uint64_t now() const {
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+            }
+
+            bool save(const std::string& path) const;
+            void clear();
+
+        private:
+
+            Buffer& getThreadBuffer();
+
+            const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+            mutable std::mutex mutex_;
+            std::vector<std::shared_ptr<Buffer>> buffers_;
+            std::atomic<uint64_t> generation_{ 1 };
+            size_t tracks_ = 0;
+        };
+
+        H2OFT_DECL TraceStorage& get_trace_storage();
+
+        // Record the scope as a span of the trace, if Options::trace is set
+        class TraceSpan {
+        public:
+
+            explicit TraceSpan(const std::string& name, const char* category = "user")
+                : enabled_(get_options().trace)
+            {
+                if (enabled_) {
+                    name_ = name;
+                    category_ = category;
+                    begin_ns_ = get_trace_storage().now();
+                }
+            }
+
+            ~TraceSpan() {
+                if (enabled_) {
+                    auto& storage = get_trace_storage();
+                    storage.record(TraceEvent{ std::move(name_), category_, begin_ns_, storage.now(), std::move(args_) });
+                }
+            }
+
+            TraceSpan(const TraceSpan&) = delete;
+            TraceSpan& operator=(const TraceSpan&) = delete;
+
+            bool isEnabled() const { return enabled_; }
+            // Members of a JSON object shown with the span, e.g. "\"size\": 42"
+            void setArgs(std::string args) { args_ = std::move(args); }
+
+        private:
+
+            bool enabled_;
+            std::string name_;
+            const char* category_ = nullptr;
+            uint64_t begin_ns_ = 0;
+            std::string args_;
+        };
+
+        // OS resource usage of a thread, or its delta over a test when collected
+        struct ResourceUsage {
+            bool collected = false;
+            Duration user_time = Duration{ 0 };
+            Duration system_time = Duration{ 0 };
+            long minor_faults = 0;
+            long major_faults = 0;
+            long voluntary_switches = 0;
+            long involuntary_switches = 0;
+            long rss_bytes = 0;       // resident set size (delta: growth over the test)
+            long max_rss_bytes = 0;   // high-water mark of the process resident set size (delta: growth over the test)
+
+            ResourceUsage& operator+=(const ResourceUsage& rhs) {
+                collected = collected || rhs.collected;
+                user_time += rhs.user_time;
+                system_time += rhs.system_time;
+                minor_faults += rhs.minor_faults;
+                major_faults += rhs.major_faults;
+                voluntary_switches += rhs.voluntary_switches;
+                involuntary_switches += rhs.involuntary_switches;
+                rss_bytes += rhs.rss_bytes;
+                max_rss_bytes += rhs.max_rss_bytes;
+                return *this;
+            }
+
+            friend ResourceUsage operator-(const ResourceUsage& lhs, const ResourceUsage& rhs) {
+                ResourceUsage result;
+                result.collected = lhs.collected && rhs.collected;
+                result.user_time = lhs.user_time - rhs.user_time;
+                result.system_time = lhs.system_time - rhs.system_time;
+                result.minor_faults = lhs.minor_faults - rhs.minor_faults;
+                result.major_faults = lhs.major_faults - rhs.major_faults;
+                result.voluntary_switches = lhs.voluntary_switches - rhs.voluntary_switches;
+                result.involuntary_switches = lhs.involuntary_switches - rhs.involuntary_switches;
+                result.rss_bytes = lhs.rss_bytes - rhs.rss_bytes;
+                result.max_rss_bytes = lhs.max_rss_bytes - rhs.max_rss_bytes;
+                return result;
+            }
+
+            friend std::ostream& operator<<(std::ostream& os, const ResourceUsage& usage) {
+                os << "user " << usage.user_time.count() << " ms, sys " << usage.system_time.count() << " ms, faults "
+                    << usage.minor_faults << " minor/" << usage.major_faults << " major, context switches "
+                    << usage.voluntary_switches << " voluntary/" << usage.involuntary_switches << " involuntary, RSS "
+                    << usage.rss_bytes / 1024 << " KB (high-water " << usage.max_rss_bytes / 1024 << " KB)";
+                return os;
+            }
+        };
+
+        // Current resource usage of the calling thread
+        H2OFT_DECL ResourceUsage resource_usage_snapshot();
+
+        // Thread safe collector of the failures and errors raised by the other threads of a test
+        class FailureSink {
+        public:
+
+            void addFailure(const std::string& message) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                failures_.push_back(message);
+            }
+
+            void addError(const std::string& message) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                errors_.push_back(message);
+            }
+
+            std::vector<std::string> getFailures() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return failures_;
+            }
+
+            std::vector<std::string> getErrors() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return errors_;
+            }
+
+            void clear() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                failures_.clear();
+                errors_.clear();
+            }
+
+        private:
+
+            mutable std::mutex mutex_;
+            std::vector<std::string> failures_;
+            std::vector<std::string> errors_;
+        };
+
+        // Durations recorded under a name by the scoped timers of a test
+        struct Timing {
+            size_t count = 0;
+            Duration total{ 0 };
+            Duration min{ 0 };
+            Duration max{ 0 };
+
+            void add(Duration duration) {
+                min = count == 0 || duration < min ? duration : min;
+                max = count == 0 || duration > max ? duration : max;
+                total += duration;
+                ++count;
+            }
+
+            Timing& operator+=(const Timing& other) {
+                if (other.count > 0) {
+                    min = count == 0 || other.min < min ? other.min : min;
+                    max = count == 0 || other.max > max ? other.max : max;
+                    total += other.total;
+                    count += other.count;
+                }
+                return *this;
+            }
+
+            Duration getMean() const { return count > 0 ? total / static_cast<double>(count) : Duration{ 0 }; }
+        };
+
+        // Last test started, receives the failures of the threads without test when it's the only one running
+        H2OFT_NO_INSTRUMENT inline std::atomic<Test*>& running_test() {
+            static std::atomic<Test*> test{ nullptr };
+            return test;
+        }
+
+        // Number of tests being run (parallel repeats or scenarios)
+        inline std::atomic<size_t>& running_tests_count() {
+            static std::atomic<size_t> count{ 0 };
+            return count;
+        }
+
+        // Virtual time of a test (Test::useVirtualClock), read through TestClock by the code under test
+        // Sleeps and timed waits complete as soon as the time reaches their deadline : the time is moved by advance(),
+        // or with auto advance to the earliest deadline, once all the threads of the test stayed blocked on the clock
+        // for a grace period of real time (a notified waiter can't be told from a blocked one before it runs again)
+        class VirtualClock {
+        public:
+
+            using Nanoseconds = std::chrono::nanoseconds;
+
+            explicit VirtualClock(bool auto_advance)
+                : auto_advance_(auto_advance) {}
+
+            VirtualClock(const VirtualClock&) = delete;
+            VirtualClock& operator=(const VirtualClock&) = delete;
+
+            // Time since the start of the test
+            Nanoseconds now() const;
+            // Move the time forward, releasing the sleeps and waits whose deadline is reached
+            void advance(Nanoseconds duration);
+            void sleep_until(Nanoseconds deadline);
+
+            // Wait on the condition variable until the predicate is true or the deadline is reached, returns the predicate
+            template<class Predicate>
+            bool wait_until(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, Nanoseconds deadline, Predicate predicate) {
+                Waiter waiter;
+                if (!predicate() && enter(deadline, waiter)) {
+                    while (!predicate() && !waiter.released.load(std::memory_order_acquire)) {
+                        // The clock can't notify a condition variable it doesn't own safely : the release is polled
+                        condition.wait_for(lock, poll_period);
+                        poll();
+                    }
+                    leave(waiter);
+                }
+                return predicate();
+            }
+
+            // Threads taking part in the auto advance : the test body, and the TestThreads it starts
+            void attach();
+            void detach();
+            // The thread waits for something else than the clock (e.g. joins a TestThread) : the time can be advanced meanwhile
+            void park();
+            void unpark();
+
+            static constexpr std::chrono::milliseconds poll_period{ 1 };
+            static constexpr std::chrono::milliseconds grace_period{ 2 };
+
+        private:
+
+            struct Waiter {
+                std::atomic<bool> released{ false };
+                std::multimap<Nanoseconds, Waiter*>::iterator entry;
+            };
+
+            // Register the waiter, false if its deadline is already reached
+            bool enter(Nanoseconds deadline, Waiter& waiter);
+            void leave(Waiter& waiter);
+            void poll();
+            // Advance to the earliest deadline if all the attached threads are blocked since the grace period, mutex_ held
+            void advance_if_blocked();
+            // Release the waiters whose deadline is reached, mutex_ held
+            void release();
+
+            mutable std::mutex mutex_;
+            std::condition_variable released_;
+            Nanoseconds now_{ 0 };
+            bool auto_advance_;
+            size_t threads_ = 1;
+            size_t blocked_ = 0;
+            std::multimap<Nanoseconds, Waiter*> waiters_;
+            // Changes of the threads states, and since when they didn't change
+            uint64_t epoch_ = 0;
+            uint64_t quiet_epoch_ = 0;
+            std::chrono::steady_clock::time_point quiet_since_;
+        };
+
+        // Standard class discribing a test
+        class Test {
+        public:
+
+            // States of the test
+            enum class Status {
+                PASSED,    // test successfuly passed
+                FAILED,    // test failed to pass (an assert failed)
+                ERROR,    // an error occured during the test :
+                // any exception was catched like bad_alloc
+                SKIPPED,// test was skipped and not run
+                CANCELLED, // test wasn't run or was dropped while running (async), the run was cancelled (fail fast or by the user)
+                NONE    // the run_scenario function wasn't run yet
+                // for the scenario holding the test
+            };
+
+            // All available constructors
+            Test()
+                : Test({}, []() {}) {}
+            Test(const TestFunctor&& test)
+                : Test("", std::move(test)) {}
+            Test(const std::string& label)
+                : Test(label, []() {}) {}
+            Test(const std::string& label, const TestFunctor&& test)
+                : test_holder_(std::make_unique<TestFunctor>(std::move(test))), label_(label), status_(Status::NONE), seed_(0), iteration_(0)
+            {}
+
+            // Copy forbidden
+            Test(const Test&) = delete;
+            Test& operator=(const Test&) = delete;
+
+            // Default move impl (for VC2013)
+            Test(Test&& test)
+                : exec_time_ms_(test.exec_time_ms_), setup_time_ms_(test.setup_time_ms_), teardown_time_ms_(test.teardown_time_ms_),
+                test_holder_(std::move(test.test_holder_)), label_(test.label_),
+                failure_reason_(test.failure_reason_), skipped_reason_(test.skipped_reason_),
+                error_(test.error_), histograms_(std::move(test.histograms_)), timings_(std::move(test.timings_)), resource_usage_(test.resource_usage_), status_(test.status_),
+                seed_(test.seed_), iteration_(test.iteration_), prerequisites_(std::move(test.prerequisites_)),
+                uses_virtual_clock_(test.uses_virtual_clock_), auto_advance_(test.auto_advance_), virtual_clock_(std::move(test.virtual_clock_))
+            {}
+            Test&& operator=(Test&& test) {
+                test_holder_ = std::move(test.test_holder_);
+                label_ = test.label_;
+                status_ = test.status_;
+                exec_time_ms_ = test.exec_time_ms_;
+                setup_time_ms_ = test.setup_time_ms_;
+                teardown_time_ms_ = test.teardown_time_ms_;
+                failure_reason_ = test.failure_reason_;
+                skipped_reason_ = test.skipped_reason_;
+                error_ = test.error_;
+                histograms_ = std::move(test.histograms_);
+                timings_ = std::move(test.timings_);
+                resource_usage_ = test.resource_usage_;
+                seed_ = test.seed_;
+                iteration_ = test.iteration_;
+                prerequisites_ = std::move(test.prerequisites_);
+                uses_virtual_clock_ = test.uses_virtual_clock_;
+                auto_advance_ = test.auto_advance_;
+                virtual_clock_ = std::move(test.virtual_clock_);
+                return std::move(*this);
+            }
+
+            Test(std::reference_wrapper<Test> test)
+                : Test(std::move(test.get()))
+            {}
+
+            // Virtual destructor impl
+            virtual ~Test() {}
+
+            // Information getters
+            const std::string& getLabel(bool verbose) const { return getLabel_private(verbose); }
+            const std::string& getFailureReason() const { return getFailureReason_private(); }
+            const std::string& getSkippedReason() const { return getSkippedReason_private(); }
+            const std::string& getError() const { return getError_private(); }
+            Duration getExecTimeMs() const { return getExecTimeMs_private(); }
+            // Time spent in the set_up and tear_down of the scenario around the test body
+            Duration getSetUpTimeMs() const { return getSetUpTimeMs_private(); }
+            Duration getTearDownTimeMs() const { return getTearDownTimeMs_private(); }
+            Status getStatus() const { return getStatus_private(); }
+            const std::map<std::string, Histogram>& getHistograms() const { return getHistograms_private(); }
+            // Durations of the scoped timers of the test, by name
+            // A copy taken under the lock of addTiming() : the threads of the test may still be adding to them
+            std::map<std::string, Timing> getTimings() const {
+                std::lock_guard<std::mutex> lock{ timings_mutex_ };
+                return getTimings_private();
+            }
+            // Resource usage delta over the test, if Options::collect_resource_usage was set
+            const ResourceUsage& getResourceUsage() const { return getResourceUsage_private(); }
+
+            // Histogram recorded by the test under the given name, created on first use
+            // Can be called from the threads of the test, a histogram is recorded by one thread at a time
+            Histogram& getHistogram(const std::string& name) {
+                std::lock_guard<std::mutex> lock{ timings_mutex_ };
+                return histograms_[name];
+            }
+
+            // Add a duration to the timing with the given name, can be called from the threads of the test
+            void addTiming(const std::string& name, Duration duration) {
+                std::lock_guard<std::mutex> lock{ timings_mutex_ };
+                timings_[name].add(duration);
+            }
+
+            // Failures and errors raised by the threads started by the test
+            FailureSink& getFailureSink() { return failure_sink_; }
+
+            // Seed and repeat iteration of the current run of the test
+            uint64_t getSeed() const { return seed_; }
+            size_t getIteration() const { return iteration_; }
+
+            // The test only runs once the test of the same scenario with this label passed, it's skipped otherwise
+            // An async test can't be a prerequisite as it runs after the others : the dependent test fails with an error
+            Test& dependsOn(const std::string& label) {
+                prerequisites_.push_back(label);
+                return *this;
+            }
+            const std::vector<std::string>& getPrerequisites() const { return prerequisites_; }
+
+            // Each run of the test gets its own virtual time starting at 0, read by TestClock
+            // Without auto advance, the time only moves with TestClock::advance()
+            Test& useVirtualClock(bool auto_advance = true) {
+                uses_virtual_clock_ = true;
+                auto_advance_ = auto_advance;
+                return *this;
+            }
+            // Virtual clock of the last run, nullptr if the test doesn't use one
+            VirtualClock* getVirtualClock() const { return virtual_clock_.get(); }
+
+            // New test running the same body, used to run repeats concurrently
+            // nullptr if the test can't be repeated this way
+            virtual std::unique_ptr<Test> clone() const {
+                auto test = std::make_unique<Test>(label_, TestFunctor{ *test_holder_ });
+                test->uses_virtual_clock_ = uses_virtual_clock_;
+                test->auto_advance_ = auto_advance_;
+                return test;
+            }
+
+        protected:
+
+            // Called by RegistryManager
+            void run(const SetUpFunctor& setup, const TearDownFunctor& teardown);
+
+            // Merge the failures and errors of the test threads into the test state
+            void collect_thread_failures();
+
+            // Run the test and capture and set the state
+            virtual void run_private();
+
+            // Call the functor and set the state according to what it raised
+            template<class Functor>
+            void run_guarded(Functor&& functor) {
+                try {
+                    functor();
+                    status_ = Status::PASSED;
+                }
+                catch (const GenericTestFailure& failure) {
+                    status_ = Status::FAILED;
+                    failure_reason_ = failure.what();
+                }
+                catch (const std::exception& e) {
+                    status_ = Status::ERROR;
+                    error_ = e.what();
+                }
+                catch (...) {
+                    status_ = Status::ERROR;
+                    error_ = "Unkown error";
+                }
+            }
+
+            // Informations getters impl
+            virtual const std::string& getLabel_private(bool /*verbose*/) const { return label_; }
+            virtual const std::string& getFailureReason_private() const { return failure_reason_; }
+            virtual const std::string& getSkippedReason_private() const { return skipped_reason_; }
+            virtual const std::string& getError_private() const { return error_; }
+            virtual Duration getExecTimeMs_private() const { return exec_time_ms_; }
+            virtual Duration getSetUpTimeMs_private() const { return setup_time_ms_; }
+            virtual Duration getTearDownTimeMs_private() const { return teardown_time_ms_; }
+            virtual Status getStatus_private() const { return status_; }
+            virtual const std::map<std::string, Histogram>& getHistograms_private() const { return histograms_; }
+            virtual const std::map<std::string, Timing>& getTimings_private() const { return timings_; }
+            virtual const ResourceUsage& getResourceUsage_private() const { return resource_usage_; }
+
+        protected:
+
+            Duration exec_time_ms_;
+            Duration setup_time_ms_{ 0 };
+            Duration teardown_time_ms_{ 0 };
+            std::unique_ptr<TestFunctor> test_holder_;
+            std::string label_;
+            std::string failure_reason_;
+            std::string skipped_reason_;
+            std::string error_;
+            std::map<std::string, Histogram> histograms_;
+            std::map<std::string, Timing> timings_;
+            // Guards timings_ and the insertions in histograms_ from the threads of this test only (not moved)
+            mutable std::mutex timings_mutex_;
+            ResourceUsage resource_usage_;
+            FailureSink failure_sink_;
+            Status status_;
+            uint64_t seed_;
+            size_t iteration_;
+            std::vector<std::string> prerequisites_;
+            bool uses_virtual_clock_ = false;
+            bool auto_advance_ = true;
+            std::shared_ptr<VirtualClock> virtual_clock_;
+
+            friend class ScenarioRegistry;
+        };
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, Test::Status status);
+
+        H2OFT_DECL std::string to_string(Test::Status status);
+
+        // Strings stored once for the whole run (labels, scenario names, messages) and referred to by id, 0 is the empty string
+        class StringPool {
+        public:
+
+            StringPool() { intern({}); }
+
+            uint32_t intern(std::string_view value);
+            const std::string& get(uint32_t id) const;
+            size_t size() const;
+
+        private:
+
+            mutable std::mutex mutex_;
+            std::deque<std::string> strings_; // Stable addresses for the keys of ids_
+            std::unordered_map<std::string_view, uint32_t> ids_;
+        };
+
+        H2OFT_DECL StringPool& get_string_pool();
+
+        // Results of a scenario in struct-of-arrays form : a row per recorded test, a column per field
+        // Counting, filtering and sorting scan the contiguous columns instead of chasing the tests through the heap
+        class ResultTable {
+        public:
+
+            static constexpr size_t status_count = static_cast<size_t>(Test::Status::NONE) + 1;
+
+            // Append the row of the test, its label and message are interned
+            void add(const Test& test, uint32_t scenario_id);
+
+            size_t size() const { return statuses_.size(); }
+            size_t count(Test::Status status) const { return counts_[static_cast<size_t>(status)]; }
+            Duration getTotalDuration() const;
+
+            // Rows with the status, in record order
+            std::vector<uint32_t> select(Test::Status status) const;
+            // Rows by decreasing duration, the count first ones only if count > 0
+            std::vector<uint32_t> sortByDuration(size_t count = 0) const;
+
+            // Columns
+            Test::Status getStatus(size_t row) const { return static_cast<Test::Status>(statuses_[row]); }
+            Duration getDuration(size_t row) const { return Duration{ durations_ms_[row] }; }
+            uint32_t getScenarioId(size_t row) const { return scenario_ids_[row]; }
+            uint32_t getLabelId(size_t row) const { return label_ids_[row]; }
+            // Failure reason, error or skipped reason according to the status
+            uint32_t getMessageId(size_t row) const { return message_ids_[row]; }
+
+            const std::string& getLabel(size_t row) const { return get_string_pool().get(label_ids_[row]); }
+            const std::string& getMessage(size_t row) const { return get_string_pool().get(message_ids_[row]); }
+            const Test& getTest(size_t row) const { return *tests_[row]; }
+
+        private:
+
+            std::vector<uint8_t> statuses_;
+            std::vector<double> durations_ms_;
+            std::vector<uint32_t> scenario_ids_;
+            std::vector<uint32_t> label_ids_;
+            std::vector<uint32_t> message_ids_;
+            std::vector<const Test*> tests_;
+            std::array<size_t, status_count> counts_{};
+        };
+
+        // Tests of a result table with a status, in record order : a range of std::reference_wrapper<const Test>
+        class TestView {
+        public:
+
+            class iterator {
+            public:
+
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::reference_wrapper<const Test>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const value_type*;
+                using reference = value_type;
+
+                iterator(const ResultTable* table, size_t row, Test::Status status)
+                    : table_(table), row_(row), status_(status) {
+                    skip();
+                }
+
+                reference operator*() const { return std::cref(table_->getTest(row_)); }
+                iterator& operator++() {
+                    ++row_;
+                    skip();
+                    return *this;
+                }
+                iterator operator++(int) {
+                    auto previous = *this;
+                    ++*this;
+                    return previous;
+                }
+                bool operator==(const iterator& other) const { return row_ == other.row_; }
+                bool operator!=(const iterator& other) const { return row_ != other.row_; }
+                size_t getRow() const { return row_; }
+
+            private:
+
+                void skip() {
+                    while (row_ < table_->size() && table_->getStatus(row_) != status_) {
+                        ++row_;
+                    }
+                }
+
+                const ResultTable* table_;
+                size_t row_;
+                Test::Status status_;
+            };
+
+            TestView(const ResultTable& table, Test::Status status)
+                : table_(&table), status_(status) {}
+
+            iterator begin() const { return iterator{ table_, 0, status_ }; }
+            iterator end() const { return iterator{ table_, table_->size(), status_ }; }
+            size_t size() const { return table_->count(status_); }
+            bool empty() const { return size() == 0; }
+            const Test& front() const { return *begin(); }
+
+        private:
+
+            const ResultTable* table_;
+            Test::Status status_;
+        };
+
+        // Thread to run a part of a test : assertion failures and exceptions raised by the function
+        // are forwarded to the test which started the thread instead of terminating the program
+        // The thread is joined on destruction
+        class TestThread {
+        public:
+
+            template<class Function, class... Args>
+            explicit TestThread(Function&& function, Args&&... args)
+                : thread_(run, attach(current_test()), std::bind(std::forward<Function>(function), std::forward<Args>(args)...))
+            {}
+
+            TestThread(TestThread&&) = default;
+            TestThread& operator=(TestThread&& rhs) {
+                join();
+                thread_ = std::move(rhs.thread_);
+                return *this;
+            }
+
+            ~TestThread() { join(); }
+
+            void join() {
+                if (thread_.joinable()) {
+                    const auto clock = current_test() != nullptr ? current_test()->getVirtualClock() : nullptr;
+                    if (clock != nullptr) {
+                        clock->park();
+                    }
+                    thread_.join();
+                    if (clock != nullptr) {
+                        clock->unpark();
+                    }
+                }
+            }
+
+        private:
+
+            // The thread takes part in the auto advance of the virtual clock of the test, if any
+            static Test* attach(Test* test) {
+                if (test != nullptr && test->getVirtualClock() != nullptr) {
+                    test->getVirtualClock()->attach();
+                }
+                return test;
+            }
+
+            static void run(Test* test, std::function<void(void)> function) {
+                current_test() = test;
+                if (test == nullptr) {
+                    function();
+                    return;
+                }
+                struct Detach {
+                    VirtualClock* clock;
+                    ~Detach() {
+                        if (clock != nullptr) {
+                            clock->detach();
+                        }
+                    }
+                } detach{ test->getVirtualClock() };
+                try {
+                    function();
+                }
+                catch (const GenericTestFailure& failure) {
+                    test->getFailureSink().addFailure(failure.what());
+                }
+                catch (const std::exception& e) {
+                    test->getFailureSink().addError(e.what());
+                }
+                catch (...) {
+                    test->getFailureSink().addError("Unkown error");
+                }
+            }
+
+            std::thread thread_;
+        };
+
+        // Clock for the code under test : the virtual time of the running test if it uses one (Test::useVirtualClock),
+        // steady_clock otherwise. The threads of a test must be TestThreads to share its virtual time
+        struct TestClock {
+            using duration = std::chrono::nanoseconds;
+            using rep = duration::rep;
+            using period = duration::period;
+            using time_point = std::chrono::time_point<TestClock>;
+            static constexpr bool is_steady = true;
+
+            static time_point now();
+            static void sleep_until(time_point deadline);
+
+            template<class Rep, class Period>
+            static void sleep_for(const std::chrono::duration<Rep, Period>& timeout) {
+                sleep_until(now() + std::chrono::duration_cast<duration>(timeout));
+            }
+
+            // Timed wait on a condition variable, returns the predicate : false if the deadline was reached first
+            template<class Predicate>
+            static bool wait_until(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, time_point deadline, Predicate predicate) {
+                if (const auto clock = virtual_clock())
+                    return clock->wait_until(condition, lock, deadline.time_since_epoch(), std::move(predicate));
+                return condition.wait_until(lock, std::chrono::steady_clock::time_point{ std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline.time_since_epoch()) },
+                    std::move(predicate));
+            }
+
+            template<class Rep, class Period, class Predicate>
+            static bool wait_for(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, const std::chrono::duration<Rep, Period>& timeout, Predicate predicate) {
+                return wait_until(condition, lock, now() + std::chrono::duration_cast<duration>(timeout), std::move(predicate));
+            }
+
+            // Move the virtual time of the running test forward, std::logic_error if it doesn't use one
+            static void advance(duration elapsed);
+
+            // Virtual clock of the running test, nullptr if none
+            static VirtualClock* virtual_clock() { return current_test() != nullptr ? current_test()->getVirtualClock() : nullptr; }
+        };
+
+        // Histogram of the running test, to record latencies from a test body
+        // Threads of the test get their own histograms by name : they are merged after the run if needed
+        H2OFT_DECL Histogram& test_histogram(const std::string& name);
+
+        // Seed of the running test, to make its randomness replayable from a reported seed and iteration
+        H2OFT_DECL uint64_t test_seed();
+
+        // Time its scope into the timing of the running test with this name (scoped_timer), and into the trace
+        class ScopedTimer {
+        public:
+
+            explicit ScopedTimer(const std::string& name)
+                : test_(current_test()), span_(name, "timer"), start_(std::chrono::high_resolution_clock::now())
+            {
+                if (test_ != nullptr) {
+                    name_ = name;
+                }
+            }
+
+            ~ScopedTimer() {
+                if (test_ != nullptr) {
+                    test_->addTiming(name_, std::chrono::high_resolution_clock::now() - start_);
+                }
+            }
+
+            ScopedTimer(const ScopedTimer&) = delete;
+            ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        private:
+
+            Test* test_;
+            std::string name_;
+            TraceSpan span_;
+            std::chrono::high_resolution_clock::time_point start_;
+        };
+
+        // Reusable barrier releasing the threads once all of them reached it
+        class Barrier {
+        public:
+
+            explicit Barrier(size_t count)
+                : count_(count), waiting_(0), generation_(0)
+            {}
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                const auto generation = generation_;
+                if (++waiting_ == count_) {
+                    waiting_ = 0;
+                    ++generation_;
+                    condition_.notify_all();
+                }
+                else {
+                    condition_.wait(lock, [this, generation]() { return generation != generation_; });
+                }
+            }
+
+        private:
+
+            std::mutex mutex_;
+            std::condition_variable condition_;
+            size_t count_;
+            size_t waiting_;
+            size_t generation_;
+        };
+
+        // Randomized perturbation applied by stress_point() on the threads of a stress test
+        struct StressPerturbation {
+            double probability = 0.;   // probability to perturb the thread at each stress point
+            size_t max_spin = 0;       // perturbation is a yield, or a busy wait of up to max_spin loops
+            uint64_t rng_state = 0;    // xorshift state, seeded per thread
+        };
+
+        inline StressPerturbation*& current_perturbation() {
+            static thread_local StressPerturbation* perturbation = nullptr;
+            return perturbation;
+        }
+
+        // Mark a point of the body where a stress test may perturb the interleaving of the threads
+        // Does nothing outside of a stress test
+        inline void stress_point() {
+            auto perturbation = current_perturbation();
+            if (perturbation == nullptr || perturbation->probability <= 0.)
+                return;
+            auto& x = perturbation->rng_state;
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            if (static_cast<double>(x >> 11) * (1. / 9007199254740992.) >= perturbation->probability)
+                return;
+            if (perturbation->max_spin == 0 || (x & 1) == 0) {
+                std::this_thread::yield();
+            }
+            else {
+                const auto spin = (x >> 1) % perturbation->max_spin;
+                std::atomic<size_t> sink{ 0 };
+                for (size_t i = 0; i < spin; ++i) { sink.store(i, std::memory_order_relaxed); }
+            }
+        }
+
+        using StressFunctor = std::function<void(size_t /*thread_index*/, size_t /*iteration*/)>;
+
+        // This class runs the body on several threads at once, for many iterations, to expose races
+        // The first failure of each thread is reported with its thread index and iteration, then all the threads stop
+        class StressTest : public Test {
+        public:
+
+            StressTest(const std::string& label, size_t threads, size_t iterations, StressFunctor&& func)
+                : Test{ label }, stress_holder_(std::move(func)), threads_(std::max<size_t>(threads, 1)), iterations_(iterations)
+            {}
+            StressTest(const std::string& label, size_t threads, size_t iterations, TestFunctor&& func)
+                : StressTest{ label, threads, iterations, [func = std::move(func)](size_t, size_t) { func(); } }
+            {}
+
+            // Perturb the threads at the stress points : yield or busy wait with the given probability
+            // The perturbations are seeded from the seed of the test (replayable with Options::seed), unless a seed is given
+            StressTest& perturb(double probability, size_t max_spin = 1000, uint64_t seed = 0) {
+                probability_ = probability;
+                max_spin_ = max_spin;
+                perturb_seed_ = seed;
+                return *this;
+            }
+
+            // Number of calls of the body that completed
+            size_t getExecutedIterations() const { return executed_; }
+            // Seed of the perturbations of the last run, the thread i is seeded with seed + i * 0x2545F4914F6CDD1D + 1
+            uint64_t getPerturbationSeed() const { return run_perturb_seed_; }
+
+            virtual std::unique_ptr<Test> clone() const override { return nullptr; }
+
+        protected:
+
+            virtual void run_private() override {
+                auto start = std::chrono::high_resolution_clock::now();
+                executed_ = 0;
+                run_perturb_seed_ = perturb_seed_ != 0 ? perturb_seed_ : seed_;
+                run_guarded([this]() {
+                    Barrier barrier{ threads_ };
+                    std::atomic<bool> stop{ false };
+                    std::atomic<size_t> executed{ 0 };
+                    std::vector<std::thread> workers;
+                    for (size_t index = 0; index < threads_; ++index) {
+                        workers.emplace_back([&, index]() {
+                            current_test() = this;
+                            StressPerturbation perturbation{ probability_, max_spin_, run_perturb_seed_ + index * 0x2545F4914F6CDD1Dull + 1 };
+                            current_perturbation() = &perturbation;
+                            barrier.wait();
+                            size_t iteration = 0;
+                            try {
+                                for (; iteration < iterations_ && !stop.load(std::memory_order_relaxed) && !is_cancelled(); ++iteration) {
+                                    stress_holder_(index, iteration);
+                                }
+                            }
+                            catch (const GenericTestFailure& failure) {
+                                failure_sink_.addFailure(context(index, iteration) + failure.what());
+                                stop = true;
+                            }
+                            catch (const std::exception& e) {
+                                failure_sink_.addError(context(index, iteration) + e.what());
+                                stop = true;
+                            }
+                            catch (...) {
+                                failure_sink_.addError(context(index, iteration) + "Unkown error");
+                                stop = true;
+                            }
+                            executed += iteration;
+                            current_perturbation() = nullptr;
+                        });
+                    }
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                    executed_ = executed;
+                });
+                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+            }
+
+        private:
+
+            std::string context(size_t index, size_t iteration) const {
+                std::ostringstream oss;
+                oss << "[thread " << index << "/" << threads_ << ", iteration " << iteration << ", seed " << seed_ << ", perturbation seed " << run_perturb_seed_ << "] ";
+                return oss.str();
+            }
+
+            StressFunctor stress_holder_;
+            size_t threads_;
+            size_t iterations_;
+            double probability_ = 0.;
+            size_t max_spin_ = 0;
+            uint64_t perturb_seed_ = 0; // 0 : the seed of the test
+            uint64_t run_perturb_seed_ = 0;
+            size_t executed_ = 0;
+        };
+
+        using FuzzFunctor = std::function<void(const uint8_t* /*data*/, size_t /*size*/)>;
+
+        // This class runs the body on byte inputs : a normal run replays the corpus directory and the saved crashes,
+        // Options::fuzz runs an in-process mutation loop over the corpus instead, guided by the coverage
+        // when built with clang's -fsanitize-coverage=inline-8bit-counters (header-only : define H2OFT_COVERAGE_HOOK in one TU)
+        // A failing input found by the loop is minimized and saved to the crashes directory of the corpus
+        // (h2oft/crashes in the temporary directory without corpus)
+        class FuzzTest : public Test {
+        public:
+
+            using Input = std::vector<uint8_t>;
+
+            FuzzTest(const std::string& label, FuzzFunctor&& func, const std::string& corpus)
+                : Test{ label }, fuzz_holder_(std::move(func)), corpus_(corpus)
+            {}
+
+            // Inputs given to the body by the last run
+            size_t getExecutions() const { return executions_; }
+            double getExecutionsPerSecond() const { return exec_time_ms_.count() > 0. ? static_cast<double>(executions_) * 1e3 / exec_time_ms_.count() : 0.; }
+            // Inputs kept by the mutation loop, and coverage features they reach (0 without coverage instrumentation)
+            size_t getCorpusSize() const { return inputs_.size(); }
+            size_t getFeatures() const { return features_; }
+            // File of the minimized failing input saved by the last run, empty if none
+            const std::string& getCrashPath() const { return crash_path_; }
+
+            std::string getReport() const;
+
+            virtual std::unique_ptr<Test> clone() const override { return nullptr; }
+
+        protected:
+
+            virtual void run_private() override;
+
+        private:
+
+            // Run the body on an input, message receives the failure or error raised
+            Status execute(const Input& input, std::string& message);
+            void replay();
+            void fuzz();
+            Input mutate(const Input& input, std::mt19937_64& rng) const;
+            Input minimize(Input input);
+            std::string getCrashDirectory() const;
+
+            FuzzFunctor fuzz_holder_;
+            std::string corpus_;
+            std::vector<Input> inputs_;
+            size_t executions_ = 0;
+            size_t features_ = 0;
+            std::string crash_path_;
+        };
+
+        // Row of a data-driven test case file, valid during the call of the body only
+        class DataRow {
+        public:
+
+            // Text of the row, without its line break
+            std::string_view getText() const { return text_; }
+
+            // Fields of a CSV row, quoted fields without their quotes (doubled quotes are kept)
+            size_t size() const { return fields_.size(); }
+            std::string_view operator[](size_t index) const { return index < fields_.size() ? fields_[index] : std::string_view{}; }
+
+            // Field of the CSV column with this name, or value of this key of a JSONL object (strings without their quotes)
+            // Empty if missing
+            std::string_view get(std::string_view name) const;
+
+        private:
+
+            std::string_view text_;
+            std::vector<std::string_view> fields_;
+            const std::vector<std::string_view>* header_ = nullptr;
+
+            friend class DataDrivenTest;
+        };
+
+        using DataRowFunctor = std::function<void(const DataRow& /*row*/)>;
+
+        // Run the body on each row of a case file : CSV with a header line, or JSON lines (.jsonl, .ndjson)
+        // The file is mapped and its rows parsed in chunks taken by Options::jobs threads, the body must then be thread safe
+        // Failing rows are reported by line number and text, up to setMaxReportedRows()
+        class DataDrivenTest : public Test {
+        public:
+
+            DataDrivenTest(const std::string& label, const std::string& path, DataRowFunctor&& func)
+                : Test{ label }, rows_holder_(std::move(func)), path_(path)
+            {}
+
+            // Bytes of the file parsed per chunk, extended to the end of its last line
+            DataDrivenTest& setChunkSize(size_t bytes) {
+                chunk_size_ = std::max<size_t>(bytes, 1);
+                return *this;
+            }
+
+            DataDrivenTest& setMaxReportedRows(size_t rows) {
+                max_reported_rows_ = rows;
+                return *this;
+            }
+
+            // Rows given to the body by the last run, and the failing ones
+            size_t getRows() const { return rows_; }
+            size_t getFailedRows() const { return failed_rows_; }
+            double getRowsPerSecond() const { return exec_time_ms_.count() > 0. ? static_cast<double>(rows_) * 1e3 / exec_time_ms_.count() : 0.; }
+
+            std::string getReport() const;
+
+            virtual std::unique_ptr<Test> clone() const override { return nullptr; }
+
+        protected:
+
+            virtual void run_private() override;
+
+        private:
+
+            DataRowFunctor rows_holder_;
+            std::string path_;
+            size_t chunk_size_ = 1 << 20;
+            size_t max_reported_rows_ = 10;
+            size_t rows_ = 0;
+            size_t failed_rows_ = 0;
+        };
+
+        // This class wrap a test and make it so it's skipped (never run)
+        class SkippedTest : public Test {
+        public:
+
+            SkippedTest(TestFunctor&& func)
+                : Test{ std::move(func) } {}
+            SkippedTest(const std::string& label, TestFunctor&& func)
+                : Test{ label, std::move(func) } {}
+            SkippedTest(const std::string& reason, const std::string& label, TestFunctor&& func)
+                : SkippedTest{ label, std::move(func) }
+            {
+                skipped_reason_ = reason;
+            }
+
+            virtual std::unique_ptr<Test> clone() const override { return std::make_unique<SkippedTest>(skipped_reason_, label_, TestFunctor{ *test_holder_ }); }
+
+        protected:
+
+            // Put state to skipped and don't run the test
+            virtual void run_private() override { status_ = Test::Status::SKIPPED; }
+        };
+
+        // Helper functions to build/skip a test case
+        H2OFT_DECL std::unique_ptr<Test> make_test(TestFunctor&& func);
+        H2OFT_DECL std::unique_ptr<Test> make_test(const std::string& label, TestFunctor&& func);
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(TestFunctor&& test);
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(const std::string& label, TestFunctor&& func);
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(const std::string& reason, const std::string& label, TestFunctor&& func);
+
+        // Event loop multiplexing the async tests of a thread
+        // Waits on timers, and on file descriptors readiness with epoll on Linux
+        // Callbacks are run on the loop thread with current_test() set to the test owning them
+        class EventLoop {
+        public:
+
+            using Clock = std::chrono::steady_clock;
+            using Callback = std::function<void(void)>;
+
+            EventLoop() {
+#if H2OFT_OS_LINUX
+                epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+#endif
+            }
+
+            ~EventLoop() {
+#if H2OFT_OS_LINUX
+                if (epoll_fd_ >= 0)
+                    close(epoll_fd_);
+#endif
+            }
+
+            EventLoop(const EventLoop&) = delete;
+            EventLoop& operator=(const EventLoop&) = delete;
+
+            void addTimer(Clock::time_point when, Test* owner, Callback callback) {
+                timers_.emplace(when, std::make_pair(owner, std::move(callback)));
+            }
+
+#if H2OFT_OS_LINUX
+            // Call back once fd is ready for the events (EPOLLIN, EPOLLOUT...), one waiter per fd
+            void addWait(int fd, uint32_t events, Test* owner, Callback callback) {
+                epoll_event event{};
+                event.events = events | EPOLLONESHOT;
+                event.data.fd = fd;
+                if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0)
+                    throw std::runtime_error{ "epoll_ctl failed to wait on the file descriptor" };
+                waits_[fd] = std::make_pair(owner, std::move(callback));
+            }
+
+            // Drop the wait on fd whatever its owner
+            void removeWait(int fd) {
+                if (waits_.erase(fd) > 0)
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            }
+#endif
+
+            // Drop the timers and waits of a test
+            void cancel(Test* owner) {
+                for (auto it = timers_.begin(); it != timers_.end();) {
+                    it = it->second.first == owner ? timers_.erase(it) : std::next(it);
+                }
+#if H2OFT_OS_LINUX
+                for (auto it = waits_.begin(); it != waits_.end();) {
+                    if (it->second.first == owner) {
+                        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->first, nullptr);
+                        it = waits_.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+#endif
+            }
+
+            // Wait for the next event, at most max_wait, and run the callbacks of what happened
+            void runOnce(Clock::duration max_wait) {
+                auto wait = max_wait;
+                if (!timers_.empty()) {
+                    wait = std::min<Clock::duration>(wait, std::max<Clock::duration>(timers_.begin()->first - Clock::now(), Clock::duration::zero()));
+                }
+                const auto wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wait + std::chrono::microseconds(999)).count());
+#if H2OFT_OS_LINUX
+                std::array<epoll_event, 64> events;
+                const auto count = epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), wait_ms);
+                for (int i = 0; i < count; ++i) {
+                    auto it = waits_.find(events[i].data.fd);
+                    if (it == waits_.end())
+                        continue;
+                    auto waiter = std::move(it->second);
+                    waits_.erase(it);
+                    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+                    dispatch(waiter.first, waiter.second);
+                }
+#else
+                std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+#endif
+                const auto now = Clock::now();
+                while (!timers_.empty() && timers_.begin()->first <= now) {
+                    auto timer = std::move(timers_.begin()->second);
+                    timers_.erase(timers_.begin());
+                    dispatch(timer.first, timer.second);
+                }
+            }
+
+        private:
+
+            void dispatch(Test* owner, const Callback& callback) {
+                current_test() = owner;
+                callback();
+                current_test() = nullptr;
+            }
+
+            std::multimap<Clock::time_point, std::pair<Test*, Callback>> timers_;
+#if H2OFT_OS_LINUX
+            int epoll_fd_ = -1;
+            std::map<int, std::pair<Test*, Callback>> waits_;
+#endif
+        };
+
+        // Event loop of the calling thread, nullptr outside of an async test
+        inline EventLoop*& current_event_loop() {
+            static thread_local EventLoop* loop = nullptr;
+            return loop;
+        }
+
+#if H2OFT_HAS_COROUTINES
+        // Coroutine type of the async tests, and of the coroutines they co_await
+        class AsyncTask {
+        public:
+
+            struct promise_type {
+                std::coroutine_handle<> continuation;
+                std::exception_ptr exception;
+
+                AsyncTask get_return_object() { return AsyncTask{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                auto final_suspend() noexcept {
+                    // Resume the awaiting coroutine if any
+                    struct FinalAwaiter {
+                        bool await_ready() noexcept { return false; }
+                        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                            const auto continuation = handle.promise().continuation;
+                            return continuation ? continuation : std::noop_coroutine();
+                        }
+                        void await_resume() noexcept {}
+                    };
+                    return FinalAwaiter{};
+                }
+                void return_void() {}
+                void unhandled_exception() { exception = std::current_exception(); }
+            };
+
+            AsyncTask(AsyncTask&& rhs) noexcept
+                : handle_(std::exchange(rhs.handle_, nullptr))
+            {}
+            AsyncTask& operator=(AsyncTask&& rhs) noexcept {
+                std::swap(handle_, rhs.handle_);
+                return *this;
+            }
+            ~AsyncTask() {
+                if (handle_)
+                    handle_.destroy();
+            }
+
+            // Start the coroutine (for the test runner)
+            void start() { handle_.resume(); }
+            bool done() const { return !handle_ || handle_.done(); }
+            // Rethrow what the coroutine raised
+            void result() const {
+                if (handle_ && handle_.promise().exception)
+                    std::rethrow_exception(handle_.promise().exception);
+            }
+
+            // co_await of a sub-task from another coroutine
+            bool await_ready() const noexcept { return done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle_.promise().continuation = awaiting;
+                return handle_;
+            }
+            void await_resume() const { result(); }
+
+        private:
+
+            explicit AsyncTask(std::coroutine_handle<promise_type> handle)
+                : handle_(handle)
+            {}
+
+            std::coroutine_handle<promise_type> handle_;
+        };
+
+        // co_await async_sleep(duration) : resume the coroutine after the duration, without blocking the loop
+        inline auto async_sleep(Duration duration) {
+            struct SleepAwaiter {
+                Duration duration;
+                bool await_ready() const { return duration <= Duration{ 0 }; }
+                void await_suspend(std::coroutine_handle<> handle) const {
+                    if (current_event_loop() == nullptr)
+                        throw std::logic_error{ "async_sleep() awaited outside of an async test" };
+                    const auto when = EventLoop::Clock::now() + std::chrono::duration_cast<EventLoop::Clock::duration>(duration);
+                    current_event_loop()->addTimer(when, current_test(), [handle]() { handle.resume(); });
+                }
+                void await_resume() const {}
+            };
+            return SleepAwaiter{ duration };
+        }
+
+#if H2OFT_OS_LINUX
+        // co_await async_wait(fd, EPOLLIN) : resume the coroutine once the file descriptor is ready
+        inline auto async_wait(int fd, uint32_t events) {
+            struct WaitAwaiter {
+                int fd;
+                uint32_t events;
+                bool await_ready() const { return false; }
+                void await_suspend(std::coroutine_handle<> handle) const {
+                    if (current_event_loop() == nullptr)
+                        throw std::logic_error{ "async_wait() awaited outside of an async test" };
+                    current_event_loop()->addWait(fd, events, current_test(), [handle]() { handle.resume(); });
+                }
+                void await_resume() const {}
+            };
+            return WaitAwaiter{ fd, events };
+        }
+
+        inline auto async_readable(int fd) { return async_wait(fd, EPOLLIN); }
+        inline auto async_writable(int fd) { return async_wait(fd, EPOLLOUT); }
+#endif
+#endif
+
+        // Started async test body : returns true once finished, rethrowing what the body raised
+        using AsyncPoller = std::function<bool(void)>;
+        // Start the async test body on the event loop of the calling thread
+        using AsyncStarter = std::function<AsyncPoller(void)>;
+
+        // Future-like object of an async test, waited on by the future waiter of its event loop (Linux), polled otherwise
+        // Dropped before being done (timed out or cancelled test), it is destroyed on a detached thread :
+        // the future of std::async waits for its task, which may never end
+        class PendingFuture {
+        public:
+
+            virtual ~PendingFuture() = default;
+
+            // True once ready, blocking at most timeout
+            virtual bool waitFor(std::chrono::milliseconds timeout) = 0;
+            bool isReady() const { return ready_.load(std::memory_order_acquire); }
+            void setReady() { ready_.store(true, std::memory_order_release); }
+
+        private:
+
+            std::atomic<bool> ready_{ false };
+        };
+
+        // Pending future of a future-like type
+        template<class Future>
+        class AsyncFutureWaiter : public PendingFuture {
+        public:
+
+            explicit AsyncFutureWaiter(Future future)
+                : future_(std::move(future))
+            {}
+
+            ~AsyncFutureWaiter() {
+                if (done_)
+                    return;
+                try {
+                    std::thread([future = std::move(future_)]() mutable { Future dropped{ std::move(future) }; }).detach();
+                }
+                catch (...) {}
+            }
+
+            AsyncFutureWaiter(const AsyncFutureWaiter&) = delete;
+            AsyncFutureWaiter& operator=(const AsyncFutureWaiter&) = delete;
+
+            virtual bool waitFor(std::chrono::milliseconds timeout) override { return future_.wait_for(timeout) == std::future_status::ready; }
+
+            // The future is only used again by the loop thread once ready, the waiter being done with it
+            bool poll() {
+                if (!isReady())
+                    return false;
+                done_ = true;
+                future_.get();
+                return true;
+            }
+
+        private:
+
+            Future future_;
+            bool done_ = false;
+        };
+
+#if H2OFT_OS_LINUX
+        // Thread waiting on the futures of the async tests of an event loop, waking the loop up through an eventfd
+        // The futures are polled in turn, the oldest one being waited on for 1 ms between two rounds
+        class FutureWaiter {
+        public:
+
+            explicit FutureWaiter(EventLoop& loop)
+                : loop_(loop)
+            {
+                fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                if (fd_ < 0)
+                    throw std::runtime_error{ "eventfd failed to wait on the futures" };
+                try {
+                    arm();
+                    thread_ = std::thread([this]() { run(); });
+                }
+                catch (...) {
+                    loop_.removeWait(fd_);
+                    close(fd_);
+                    throw;
+                }
+            }
+
+            ~FutureWaiter() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+                condition_.notify_one();
+                thread_.join();
+                loop_.removeWait(fd_);
+                close(fd_);
+            }
+
+            FutureWaiter(const FutureWaiter&) = delete;
+            FutureWaiter& operator=(const FutureWaiter&) = delete;
+
+            // The future is forgotten once ready or dropped by its test
+            void add(const std::shared_ptr<PendingFuture>& future) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    futures_.push_back(future);
+                }
+                condition_.notify_one();
+            }
+
+        private:
+
+            // A wake up only ends the wait of the loop, the tests then poll their futures
+            void arm() {
+                loop_.addWait(fd_, EPOLLIN, nullptr, [this]() {
+                    uint64_t count;
+                    if (read(fd_, &count, sizeof(count)) < 0) {}
+                    try {
+                        arm();
+                    }
+                    catch (...) {} // The loop still wakes up at least every 100 ms
+                });
+            }
+
+            void run() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!stop_) {
+                    if (futures_.empty()) {
+                        condition_.wait(lock, [this]() { return stop_ || !futures_.empty(); });
+                        continue;
+                    }
+                    std::vector<std::shared_ptr<PendingFuture>> pending;
+                    for (const auto& future : futures_) {
+                        if (auto locked = future.lock())
+                            pending.push_back(std::move(locked));
+                    }
+                    futures_.clear();
+                    lock.unlock();
+                    bool ready = false;
+                    for (const auto& future : pending) {
+                        if (future->waitFor(std::chrono::milliseconds(0))) {
+                            future->setReady();
+                            ready = true;
+                        }
+                    }
+                    if (!ready && !pending.empty() && pending.front()->waitFor(std::chrono::milliseconds(1))) {
+                        pending.front()->setReady();
+                        ready = true;
+                    }
+                    if (ready) {
+                        const uint64_t one = 1;
+                        if (write(fd_, &one, sizeof(one)) < 0) {}
+                    }
+                    std::vector<std::weak_ptr<PendingFuture>> remaining;
+                    for (const auto& future : pending) {
+                        if (!future->isReady())
+                            remaining.push_back(future);
+                    }
+                    // Releases the futures dropped by their test meanwhile
+                    pending.clear();
+                    lock.lock();
+                    futures_.insert(futures_.begin(), remaining.begin(), remaining.end());
+                }
+            }
+
+            EventLoop& loop_;
+            int fd_ = -1;
+            std::mutex mutex_;
+            std::condition_variable condition_;
+            std::vector<std::weak_ptr<PendingFuture>> futures_;
+            bool stop_ = false;
+            std::thread thread_;
+        };
+
+        // Future waiter of the event loop of the calling thread, created by its first future
+        inline std::unique_ptr<FutureWaiter>& current_future_waiter() {
+            static thread_local std::unique_ptr<FutureWaiter> waiter;
+            return waiter;
+        }
+#endif
+
+        // Build the starter of a callable returning a coroutine (AsyncTask) or a future-like object (wait_for() and get())
+        // future is set for the latter : it is waited on by the future waiter of the loop (Linux), polled every 1 ms otherwise
+        template<class Functor>
+        AsyncStarter make_async_starter(Functor func, bool& future) {
+            using Result = std::decay_t<decltype(func())>;
+#if H2OFT_HAS_COROUTINES
+            if constexpr (std::is_same_v<Result, AsyncTask>) {
+                future = false;
+                return [func = std::move(func)]() mutable -> AsyncPoller {
+                    auto task = std::make_shared<AsyncTask>(func());
+                    task->start();
+                    return [task]() {
+                        if (!task->done())
+                            return false;
+                        task->result();
+                        return true;
+                    };
+                };
+            }
+            else
+#endif
+            {
+                future = true;
+                return [func = std::move(func)]() mutable -> AsyncPoller {
+                    auto waiter = std::make_shared<AsyncFutureWaiter<Result>>(func());
+#if H2OFT_OS_LINUX
+                    auto& futures = current_future_waiter();
+                    if (!futures)
+                        futures = std::make_unique<FutureWaiter>(*current_event_loop());
+                    futures->add(waiter);
+                    return [waiter]() { return waiter->poll(); };
+#else
+                    return [waiter]() {
+                        if (!waiter->isReady() && waiter->waitFor(std::chrono::milliseconds(0)))
+                            waiter->setReady();
+                        return waiter->poll();
+                    };
+#endif
+                };
+            }
+        }
+
+        // This class runs a test waiting on timers, file descriptors or futures without holding the runner thread
+        // The async tests of a scenario run concurrently on Options::async_threads event loops,
+        // after its other tests whatever the registration order or the shuffle
+        class AsyncTest : public Test {
+        public:
+
+            template<class Functor>
+            AsyncTest(const std::string& label, Functor&& func, Duration timeout)
+                : Test{ label }, timeout_(timeout)
+            {
+                starter_ = make_async_starter(std::forward<Functor>(func), future_);
+            }
+
+            Duration getTimeout() const { return timeout_; }
+
+            virtual std::unique_ptr<Test> clone() const override { return nullptr; }
+
+            // Run the tests concurrently, each thread running an event loop over its share of the tests
+            // set_up and tear_down are called on the loop threads before and after each test
+            // The futures of the timed out tests are left to finish on detached threads
+            static void run_all(const std::vector<AsyncTest*>& tests, const SetUpFunctor& setup, const TearDownFunctor& teardown, size_t threads) {
+                threads = std::max<size_t>(std::min(threads, tests.size()), 1);
+                auto run_loop = [&](size_t thread_index) {
+                    EventLoop loop;
+                    current_event_loop() = &loop;
+                    std::vector<AsyncTest*> pending;
+                    for (auto index = thread_index; index < tests.size(); index += threads) {
+                        tests[index]->start(loop, setup);
+                        pending.push_back(tests[index]);
+                    }
+                    while (!pending.empty()) {
+                        pending.erase(std::remove_if(pending.begin(), pending.end(), [&](AsyncTest* test) {
+                            return test->poll(loop, teardown);
+                        }), pending.end());
+                        if (pending.empty())
+                            break;
+                        auto wait = std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::milliseconds(100));
+                        for (auto test : pending) {
+#if H2OFT_OS_LINUX
+                            wait = std::min(wait, test->deadline_ - EventLoop::Clock::now());
+#else
+                            wait = std::min(wait, test->future_ ? std::chrono::duration_cast<EventLoop::Clock::duration>(std::chrono::milliseconds(1)) : test->deadline_ - EventLoop::Clock::now());
+#endif
+                        }
+                        loop.runOnce(std::max(wait, EventLoop::Clock::duration::zero()));
+                    }
+#if H2OFT_OS_LINUX
+                    current_future_waiter() = nullptr;
+#endif
+                    current_event_loop() = nullptr;
+                };
+                std::vector<std::thread> workers;
+                for (size_t index = 1; index < threads; ++index) {
+                    workers.emplace_back(run_loop, index);
+                }
+                run_loop(0);
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+            }
+
+        protected:
+
+            // Run alone on an event loop (set up and tear down are done by Test::run)
+            virtual void run_private() override {
+                run_all({ this }, []() {}, []() {}, 1);
+            }
+
+        private:
+
+            void start(EventLoop& loop, const SetUpFunctor& setup) {
+                current_test() = this;
+                status_ = Status::NONE;
+                failure_reason_.clear();
+                error_.clear();
+                histograms_.clear();
+                failure_sink_.clear();
+                finished_ = false;
+                if (setup) setup();
+                start_ = std::chrono::high_resolution_clock::now();
+                deadline_ = EventLoop::Clock::now() + std::chrono::duration_cast<EventLoop::Clock::duration>(timeout_);
+                run_guarded([this]() {
+                    poller_ = starter_();
+                });
+                if (status_ != Status::PASSED) {
+                    finish(loop, nullptr);
+                }
+                status_ = finished_ ? status_ : Status::NONE;
+                current_test() = nullptr;
+            }
+
+            // Check if the test finished or timed out, true once done
+            bool poll(EventLoop& loop, const TearDownFunctor& teardown) {
+                if (finished_) {
+                    if (teardown) teardown();
+                    return true;
+                }
+                current_test() = this;
+                bool done = false;
+                run_guarded([this, &done]() {
+                    done = poller_();
+                });
+                if (!done && status_ == Status::PASSED) {
+                    status_ = Status::NONE;
+                    if (is_cancelled()) {
+                        // Checked on every wake up of the loop (at least every 100 ms), dropped like a timed out test
+                        status_ = Status::CANCELLED;
+                        skipped_reason_ = "Run cancelled while running: " + get_cancellation_token().getReason();
+                    }
+                    else if (EventLoop::Clock::now() < deadline_) {
+                        current_test() = nullptr;
+                        return false;
+                    }
+                    else {
+                        std::ostringstream oss;
+                        oss << "Async test timed out after " << timeout_.count() << " ms";
+                        status_ = Status::ERROR;
+                        error_ = oss.str();
+                    }
+                }
+                finish(loop, &teardown);
+                current_test() = nullptr;
+                return true;
+            }
+
+            void finish(EventLoop& loop, const TearDownFunctor* teardown) {
+                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start_;
+                loop.cancel(this);
+                poller_ = nullptr;
+                collect_thread_failures();
+                failure_sink_.clear();
+                finished_ = true;
+                if (teardown != nullptr && *teardown) {
+                    (*teardown)();
+                }
+            }
+
+            AsyncStarter starter_;
+            AsyncPoller poller_;
+            Duration timeout_;
+            bool future_ = true;
+            bool finished_ = false;
+            std::chrono::high_resolution_clock::time_point start_;
+            EventLoop::Clock::time_point deadline_;
+        };
+
+        // Verdict of a benchmark compared to its baseline
+        enum class BenchmarkVerdict {
+            IMPROVED,   // significantly faster than the baseline
+            REGRESSED,  // significantly slower than the baseline
+            UNCHANGED,  // no significant difference with the baseline
+            NONE        // no baseline (or not enough samples) to compare with
+        };
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, BenchmarkVerdict verdict);
+
+        // Result of the comparison between the samples of a baseline and the current ones
+        // Shifts are relative to the baseline median (0.1 means 10% slower)
+        struct BenchmarkComparison {
+            BenchmarkVerdict verdict = BenchmarkVerdict::NONE;
+            double p_value = 1.;
+            double shift = 0.;
+            double shift_low = 0.;
+            double shift_high = 0.;
+        };
+
+        // Upper quantile of the standard normal distribution (Abramowitz & Stegun 26.2.23)
+        // Valid for 0 < p <= 0.5, absolute error < 4.5e-4
+        H2OFT_DECL double normal_upper_quantile(double p);
+
+        H2OFT_DECL double median(std::vector<double> values);
+
+        // Mann-Whitney U test between two sets of samples (normal approximation with tie correction)
+        // The shift and its confidence interval are given by the Hodges-Lehmann estimator
+        H2OFT_DECL BenchmarkComparison compare_samples(const std::vector<double>& baseline, const std::vector<double>& current, double significance);
+
+        // Global storage of benchmark samples : the baseline loaded from a file and the current run
+        // Samples are durations in ms of one iteration of the benchmark body, keyed by benchmark label
+        class BenchmarkStorage {
+        public:
+
+            using Samples = std::vector<double>;
+
+            // Load the baseline file saved by a previous run
+            bool loadBaseline(const std::string& path) {
+                std::ifstream file(path);
+                std::string header;
+                if (!std::getline(file, header) || header != file_header())
+                    return false;
+                baseline_.clear();
+                std::string label;
+                while (std::getline(file, label)) {
+                    size_t count = 0;
+                    file >> count;
+                    Samples samples(count);
+                    for (auto& sample : samples) {
+                        file >> sample;
+                    }
+                    if (!file)
+                        return false;
+                    file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                    baseline_[label] = std::move(samples);
+                }
+                return true;
+            }
+
+            // Save the samples of the current run so they can be used as a baseline later
+            bool saveRun(const std::string& path) const {
+                std::ofstream file(path);
+                file << file_header() << '\n';
+                file.precision(std::numeric_limits<double>::max_digits10);
+                for (const auto& run : run_) {
+                    file << run.first << '\n' << run.second.size();
+                    for (auto sample : run.second) {
+                        file << ' ' << sample;
+                    }
+                    file << '\n';
+                }
+                return static_cast<bool>(file);
+            }
+
+            const Samples* getBaseline(const std::string& label) const {
+                auto it = baseline_.find(label);
+                return it != baseline_.end() ? &it->second : nullptr;
+            }
+            void setRun(const std::string& label, Samples samples) { run_[label] = std::move(samples); }
+            const std::map<std::string, Samples>& getRun() const { return run_; }
+
+            // Probability of wrongly detecting a difference (default 1%)
+            double getSignificance() const { return significance_; }
+            void setSignificance(double significance) { significance_ = significance; }
+            // Relative slowdown above which a regression fails the benchmark (default 5%)
+            double getRegressionThreshold() const { return regression_threshold_; }
+            void setRegressionThreshold(double threshold) { regression_threshold_ = threshold; }
+            // Minimal duration of a sample when the iterations count is calibrated (default 1 ms)
+            Duration getMinSampleTime() const { return min_sample_time_; }
+            void setMinSampleTime(Duration duration) { min_sample_time_ = duration; }
+            // Relative standard error of the mean of the samples (cv / sqrt(samples)) under which a benchmark is stable (default 2%)
+            double getStabilityTarget() const { return stability_target_; }
+            void setStabilityTarget(double error) { stability_target_ = error; }
+            // Time a benchmark may spend adding samples until they are stable (default 500 ms, 0 to disable)
+            Duration getSamplingBudget() const { return sampling_budget_; }
+            void setSamplingBudget(Duration budget) { sampling_budget_ = budget; }
+
+            // Cores the benchmark threads are pinned to while they run (Linux), none if empty
+            const std::vector<int>& getCpuAffinity() const { return cpu_affinity_; }
+            void setCpuAffinity(std::vector<int> cpus) { cpu_affinity_ = std::move(cpus); }
+            // Raise the priority of the benchmark threads while they run (Linux, needs CAP_SYS_NICE or RLIMIT_NICE)
+            bool getRaisePriority() const { return raise_priority_; }
+            void setRaisePriority(bool raise) { raise_priority_ = raise; }
+            // Size of the buffer swept to evict the caches before a cold sample, larger than the last level cache (default 64 MB)
+            size_t getEvictionSize() const { return eviction_size_; }
+            void setEvictionSize(size_t bytes) { eviction_size_ = bytes; }
+
+            // Noise sources of the machine (scaling governor, turbo, load, busy SMT siblings), checked before the first benchmark
+            const std::vector<std::string>& getEnvironmentWarnings();
+
+        private:
+
+            static const char* file_header() { return "H2OFastTests benchmark baseline v1"; }
+
+            std::map<std::string, Samples> baseline_;
+            std::map<std::string, Samples> run_;
+            double significance_ = 0.01;
+            double regression_threshold_ = 0.05;
+            Duration min_sample_time_ = Duration{ 1. };
+            double stability_target_ = 0.02;
+            Duration sampling_budget_ = Duration{ 500. };
+            std::vector<int> cpu_affinity_;
+            bool raise_priority_ = false;
+            size_t eviction_size_ = size_t{ 64 } << 20;
+            std::once_flag environment_checked_;
+            std::vector<std::string> environment_warnings_;
+        };
+
+        H2OFT_DECL BenchmarkStorage& get_benchmark_storage();
+
+        // Noise sources for benchmarks pinned to the cpus (all the cpus if empty)
+        H2OFT_DECL std::vector<std::string> check_benchmark_environment(const std::vector<int>& cpus, bool raise_priority);
+
+        H2OFT_DECL double coefficient_of_variation(const std::vector<double>& values);
+
+        // Pin the calling thread and raise its priority as set in the benchmark storage, both restored on destruction
+        // The threads it starts meanwhile inherit them
+        class BenchmarkEnvironment {
+        public:
+
+            BenchmarkEnvironment();
+            ~BenchmarkEnvironment();
+
+            BenchmarkEnvironment(const BenchmarkEnvironment&) = delete;
+            BenchmarkEnvironment& operator=(const BenchmarkEnvironment&) = delete;
+
+        private:
+
+#if H2OFT_OS_LINUX
+            cpu_set_t previous_affinity_;
+            bool pinned_ = false;
+            int previous_priority_ = 0;
+            bool prioritized_ = false;
+#endif
+        };
+
+        // Prevent the compiler from optimizing away a value, or the computation producing it
+#if defined(__GNUC__) || defined(__clang__)
+        template<class T>
+        inline void DoNotOptimize(const T& value) {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+
+        template<class T>
+        inline void DoNotOptimize(T& value) {
+            asm volatile("" : "+m"(value) : : "memory");
+        }
+
+        // Force the compiler to consider that all the memory may have been read or written
+        inline void ClobberMemory() {
+            asm volatile("" : : : "memory");
+        }
+#else
+        inline void use_char_pointer(const volatile char*) {}
+
+        template<class T>
+        inline void DoNotOptimize(const T& value) {
+            use_char_pointer(&reinterpret_cast<const volatile char&>(value));
+            _ReadWriteBarrier();
+        }
+
+        // Force the compiler to consider that all the memory may have been read or written
+        inline void ClobberMemory() {
+            _ReadWriteBarrier();
+        }
+#endif
+
+        // Write then read every cache line of the buffer so the caches only hold it, returns the time spent
+        H2OFT_DECL Duration evict_caches(std::vector<char>& buffer);
+
+        // Scratch memory handed to a benchmark body, grown on demand and kept until released
+        // Its pages are mapped on each growth (Linux) so they are faulted in on first touch, as the allocator may reuse warm ones
+        class BenchmarkMemory {
+        public:
+
+            BenchmarkMemory() = default;
+            ~BenchmarkMemory() { release(); }
+
+            BenchmarkMemory(const BenchmarkMemory&) = delete;
+            BenchmarkMemory& operator=(const BenchmarkMemory&) = delete;
+
+            char* get(size_t bytes) {
+                if (bytes > size_) {
+                    release();
+#if H2OFT_OS_LINUX
+                    auto data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if (data == MAP_FAILED)
+                        throw std::bad_alloc{};
+                    data_ = static_cast<char*>(data);
+#else
+                    data_ = new char[bytes];
+#endif
+                    size_ = bytes;
+                }
+                return data_;
+            }
+
+            void release() {
+                if (data_) {
+#if H2OFT_OS_LINUX
+                    munmap(data_, size_);
+#else
+                    delete[] data_;
+#endif
+                }
+                data_ = nullptr;
+                size_ = 0;
+            }
+
+        private:
+
+            char* data_ = nullptr;
+            size_t size_ = 0;
+        };
+
+        // State given to each call of a benchmark body
+        // Allows to exclude code from the timing and to declare the work done by one call
+        class BenchmarkState {
+        public:
+
+            explicit BenchmarkState(size_t range = 0, size_t thread_index = 0, size_t threads = 1)
+                : range_(range), thread_index_(thread_index), threads_(threads)
+            {}
+
+            // Input size of the current call for parameter sweeps
+            size_t getRange() const { return range_; }
+            // Index of the calling thread and number of threads running the body for threaded benchmarks
+            size_t getThreadIndex() const { return thread_index_; }
+            size_t getThreads() const { return threads_; }
+
+            // Stop the timer, the code until resumeTiming() isn't measured
+            void pauseTiming() { pause_start_ = std::chrono::high_resolution_clock::now(); }
+            void resumeTiming() { paused_ += std::chrono::high_resolution_clock::now() - pause_start_; }
+
+            // Work done by one call of the body, used to report the throughput
+            void setItemsProcessed(size_t items) { items_processed_ = items; }
+            void setBytesProcessed(size_t bytes) { bytes_processed_ = bytes; }
+
+            size_t getItemsProcessed() const { return items_processed_; }
+            size_t getBytesProcessed() const { return bytes_processed_; }
+            Duration getPausedTime() const { return paused_; }
+
+            // Uninitialized scratch memory of at least bytes, kept between the calls of a sample
+            // It's fresh for each cold sample of a benchmark run with coldCache(true)
+            char* getMemory(size_t bytes) { return (memory_ ? *memory_ : own_memory_).get(bytes); }
+
+        private:
+
+            size_t range_;
+            size_t thread_index_;
+            size_t threads_;
+            BenchmarkMemory* memory_ = nullptr;
+            BenchmarkMemory own_memory_;
+            std::chrono::high_resolution_clock::time_point pause_start_;
+            Duration paused_ = Duration{ 0 };
+            size_t items_processed_ = 0;
+            size_t bytes_processed_ = 0;
+
+            friend class Benchmark;
+        };
+
+        using BenchmarkFunctor = std::function<void(BenchmarkState&)>;
+
+        // This class wraps a test and runs it as a benchmark : the body is timed over several samples
+        // and compared against the baseline if any
+        class Benchmark : public Test {
+        public:
+
+            // iterations = 0 calibrates the number of body calls per sample
+            Benchmark(const std::string& label, BenchmarkFunctor&& func, size_t samples, size_t iterations)
+                : Test{ label }, benchmark_holder_(std::move(func)),
+                samples_count_(std::max<size_t>(samples, 1)), iterations_(iterations), calibrate_(iterations == 0)
+            {}
+            Benchmark(const std::string& label, TestFunctor&& func, size_t samples, size_t iterations)
+                : Benchmark{ label, [func = std::move(func)](BenchmarkState&) { func(); }, samples, iterations }
+            {}
+
+            // Also time each call of the body to fill the "latency" histogram (one more pass over the iterations)
+            Benchmark& recordLatencies(bool record = true) {
+                record_latencies_ = record;
+                return *this;
+            }
+
+            // Also time samples of a single call of the body run after evicting the caches, reported next to the warm ones
+            // fresh_memory releases the memory given by BenchmarkState::getMemory() before each cold sample
+            // eviction_bytes = 0 sweeps BenchmarkStorage::getEvictionSize() bytes
+            Benchmark& coldCache(bool fresh_memory = false, size_t eviction_bytes = 0) {
+                cold_cache_ = true;
+                fresh_memory_ = fresh_memory;
+                eviction_bytes_ = eviction_bytes;
+                return *this;
+            }
+
+            // Duration of one iteration of the body for each sample
+            const std::vector<Duration>& getSamples() const { return samples_; }
+            // Duration of the single call of each cold sample, empty in warm mode
+            const std::vector<Duration>& getColdSamples() const { return cold_samples_; }
+            // Standard deviation of the samples relative to their mean
+            double getCoefficientOfVariation() const {
+                std::vector<double> samples;
+                for (const auto& sample : samples_) {
+                    samples.push_back(sample.count());
+                }
+                return coefficient_of_variation(samples);
+            }
+            // Standard error of the mean of the samples relative to it, shrinks as samples are added
+            double getRelativeStandardError() const {
+                return samples_.empty() ? 0. : getCoefficientOfVariation() / std::sqrt(static_cast<double>(samples_.size()));
+            }
+            const BenchmarkComparison& getComparison() const { return comparison_; }
+            size_t getIterations() const { return iterations_; }
+            Duration getMedian() const {
+                std::vector<double> samples;
+                for (const auto& sample : samples_) {
+                    samples.push_back(sample.count());
+                }
+                return Duration{ median(samples) };
+            }
+            Duration getColdMedian() const {
+                std::vector<double> samples;
+                for (const auto& sample : cold_samples_) {
+                    samples.push_back(sample.count());
+                }
+                return Duration{ samples.empty() ? 0. : median(samples) };
+            }
+            // Throughput based on the median duration of an iteration, 0 if not declared
+            double getItemsPerSecond() const { return per_second(items_processed_); }
+            double getBytesPerSecond() const { return per_second(bytes_processed_); }
+
+            // Benchmarks measure a single run
+            virtual std::unique_ptr<Test> clone() const override { return nullptr; }
+
+            // One line report of latency, throughput and comparison to the baseline
+            virtual std::string getReport() const {
+                std::ostringstream oss;
+                const auto error = getRelativeStandardError();
+                oss << samples_.size() << " samples of " << iterations_ << " iterations, median " << getMedian().count() << " ms/iter, cv "
+                    << getCoefficientOfVariation() * 100. << "%, error +/-" << error * 100. << "%";
+                if (error > get_benchmark_storage().getStabilityTarget()) {
+                    oss << " (unstable)";
+                }
+                if (items_processed_ > 0) {
+                    oss << ", " << getItemsPerSecond() << " items/s";
+                }
+                if (bytes_processed_ > 0) {
+                    oss << ", " << getBytesPerSecond() / 1e9 << " GB/s";
+                }
+                if (!cold_samples_.empty()) {
+                    const auto warm = getMedian().count();
+                    oss << ", cold median " << getColdMedian().count() << " ms/iter";
+                    if (warm > 0.) {
+                        oss << " (x" << getColdMedian().count() / warm << " warm)";
+                    }
+                }
+                if (comparison_.verdict != BenchmarkVerdict::NONE) {
+                    oss << ", " << comparison_.verdict << " " << comparison_.shift * 100. << "% ["
+                        << comparison_.shift_low * 100. << "%, " << comparison_.shift_high * 100. << "%] (p = " << comparison_.p_value << ")";
+                }
+                return oss.str();
+            }
+
+        protected:
+
+            // Measure then compare to the baseline
+            virtual void run_private() override {
+                auto start = std::chrono::high_resolution_clock::now();
+                comparison_ = {};
+                run_guarded([this]() {
+                    const BenchmarkEnvironment environment;
+                    measure(0);
+                    measure_cold(0);
+                });
+                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+                if (status_ == Status::PASSED) {
+                    compare_to_baseline();
+                }
+            }
+
+            // Run the body (once for warm-up), then time each sample for the given input size
+            void measure(size_t range) {
+                samples_.clear();
+                BenchmarkState state{ range };
+                state.memory_ = &memory_;
+                benchmark_holder_(state);
+                items_processed_ = state.getItemsProcessed();
+                bytes_processed_ = state.getBytesProcessed();
+                if (calibrate_) {
+                    calibrate(range);
+                }
+                for (size_t sample = 0; sample < samples_count_; ++sample) {
+                    samples_.push_back(time_iterations(range, iterations_) / static_cast<double>(iterations_));
+                }
+                extend_until_stable(range);
+                if (record_latencies_) {
+                    record_latencies(range);
+                }
+            }
+
+            // Add samples until the relative standard error of their mean reaches the stability target, or the sampling budget is spent
+            // Mean and variance are updated incrementally (Welford)
+            void extend_until_stable(size_t range) {
+                const auto& storage = get_benchmark_storage();
+                const auto start = std::chrono::high_resolution_clock::now();
+                const auto max_samples = samples_count_ * 100;
+                double count = 0.;
+                double mean = 0.;
+                double m2 = 0.;
+                auto add = [&](double sample) {
+                    count += 1.;
+                    const auto delta = sample - mean;
+                    mean += delta / count;
+                    m2 += delta * (sample - mean);
+                };
+                auto relative_error = [&]() {
+                    return count < 2. || mean <= 0. ? 0. : std::sqrt(m2 / (count - 1.) / count) / mean;
+                };
+                for (const auto& sample : samples_) {
+                    add(sample.count());
+                }
+                while (samples_.size() < max_samples && relative_error() > storage.getStabilityTarget() &&
+                    std::chrono::high_resolution_clock::now() - start < storage.getSamplingBudget()) {
+                    samples_.push_back(time_iterations(range, iterations_) / static_cast<double>(iterations_));
+                    add(samples_.back().count());
+                }
+            }
+
+            // Time a single call per sample after sweeping the caches, the sweep (and the release of the memory) isn't measured
+            // The sweeps are recorded in the "cache eviction" timing
+            void measure_cold(size_t range) {
+                cold_samples_.clear();
+                if (!cold_cache_)
+                    return;
+                std::vector<char> eviction(eviction_bytes_ > 0 ? eviction_bytes_ : get_benchmark_storage().getEvictionSize());
+                for (size_t sample = 0; sample < samples_count_; ++sample) {
+                    if (fresh_memory_) {
+                        memory_.release();
+                    }
+                    addTiming("cache eviction", evict_caches(eviction));
+                    BenchmarkState state{ range };
+                    state.memory_ = &memory_;
+                    const auto start = std::chrono::high_resolution_clock::now();
+                    benchmark_holder_(state);
+                    cold_samples_.push_back(std::chrono::high_resolution_clock::now() - start - state.getPausedTime());
+                }
+            }
+
+            // Time each call on its own, without the paused time
+            void record_latencies(size_t range) {
+                auto& latencies = getHistogram(range == 0 ? std::string{ "latency" } : "latency n=" + std::to_string(range));
+                latencies.reset();
+                BenchmarkState state{ range };
+                state.memory_ = &memory_;
+                for (size_t i = 0; i < samples_count_ * iterations_; ++i) {
+                    const auto paused = state.getPausedTime();
+                    const auto start = std::chrono::high_resolution_clock::now();
+                    benchmark_holder_(state);
+                    latencies.record(std::chrono::high_resolution_clock::now() - start - (state.getPausedTime() - paused));
+                }
+            }
+
+            // Measured time of the iterations, without the paused time
+            Duration time_iterations(size_t range, size_t iterations) {
+                BenchmarkState state{ range };
+                state.memory_ = &memory_;
+                auto start = std::chrono::high_resolution_clock::now();
+                for (size_t i = 0; i < iterations; ++i) {
+                    benchmark_holder_(state);
+                }
+                return std::chrono::high_resolution_clock::now() - start - state.getPausedTime();
+            }
+
+            // Double the iterations count until a sample lasts long enough to be measurable
+            void calibrate(size_t range) {
+                const auto min_time = get_benchmark_storage().getMinSampleTime();
+                iterations_ = 1;
+                while (time_iterations(range, iterations_) < min_time && iterations_ < (size_t{ 1 } << 30)) {
+                    iterations_ *= 2;
+                }
+            }
+
+        private:
+
+            double per_second(size_t processed) const {
+                const auto median_ms = getMedian().count();
+                return median_ms > 0. ? static_cast<double>(processed) * 1000. / median_ms : 0.;
+            }
+
+            void compare_to_baseline() {
+                auto& storage = get_benchmark_storage();
+                BenchmarkStorage::Samples samples;
+                for (const auto& sample : samples_) {
+                    samples.push_back(sample.count());
+                }
+                if (const auto baseline = storage.getBaseline(label_)) {
+                    comparison_ = compare_samples(*baseline, samples, storage.getSignificance());
+                    if (comparison_.verdict == BenchmarkVerdict::REGRESSED && comparison_.shift > storage.getRegressionThreshold()) {
+                        std::ostringstream oss;
+                        oss << "Benchmark regressed by " << comparison_.shift * 100. << "% [" << comparison_.shift_low * 100.
+                            << "%, " << comparison_.shift_high * 100. << "%] (p = " << comparison_.p_value << ", threshold "
+                            << storage.getRegressionThreshold() * 100. << "%)";
+                        status_ = Status::FAILED;
+                        failure_reason_ = oss.str();
+                    }
+                }
+                storage.setRun(label_, std::move(samples));
+            }
+
+        protected:
+
+            BenchmarkFunctor benchmark_holder_;
+            size_t samples_count_;
+            size_t iterations_;
+            bool calibrate_;
+            bool record_latencies_ = false;
+            bool cold_cache_ = false;
+            bool fresh_memory_ = false;
+            size_t eviction_bytes_ = 0;
+            size_t items_processed_ = 0;
+            size_t bytes_processed_ = 0;
+            BenchmarkMemory memory_;
+            std::vector<Duration> samples_;
+            std::vector<Duration> cold_samples_;
+            BenchmarkComparison comparison_;
+        };
+
+        H2OFT_DECL std::unique_ptr<Test> make_benchmark(const std::string& label, TestFunctor&& func, size_t samples, size_t iterations);
+        H2OFT_DECL std::unique_ptr<Test> make_benchmark(const std::string& label, BenchmarkFunctor&& func, size_t samples, size_t iterations);
+
+        // Asymptotic complexities a benchmark can be fitted against
+        enum Complexity {
+            O_1,
+            O_LogN,
+            O_N,
+            O_NLogN,
+            O_N2
+        };
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, Complexity complexity);
+
+        // Least square fit of time = coefficient * f(n)
+        // rms is the root mean square of the residuals, relative to the mean time
+        struct ComplexityFit {
+            Complexity complexity = O_1;
+            double coefficient = 0.;
+            double rms = 0.;
+        };
+
+        H2OFT_DECL double complexity_function(Complexity complexity, double n);
+
+        // points : input size and time measured for this size
+        H2OFT_DECL ComplexityFit fit_complexity(const std::vector<std::pair<double, double>>& points, Complexity complexity);
+
+        // Complexity with the lowest RMS error
+        H2OFT_DECL ComplexityFit best_fit_complexity(const std::vector<std::pair<double, double>>& points);
+
+        // This class runs a benchmark over a geometric range of input sizes and fits its asymptotic complexity
+        // The input size of the current call is given by BenchmarkState::getRange()
+        class ComplexityBenchmark : public Benchmark {
+        public:
+
+            ComplexityBenchmark(const std::string& label, BenchmarkFunctor&& func, size_t range_min, size_t range_max, size_t multiplier, size_t samples)
+                : Benchmark{ label, std::move(func), samples, 0 }
+            {
+                const auto factor = std::max<size_t>(multiplier, 2);
+                for (auto range = std::max<size_t>(range_min, 1); range < range_max; range *= factor) {
+                    ranges_.push_back(range);
+                }
+                ranges_.push_back(std::max<size_t>(range_max, 1));
+            }
+
+            // Fail the benchmark when its best fit grows faster than the given complexity
+            ComplexityBenchmark& expectComplexity(Complexity complexity) {
+                expected_ = complexity;
+                has_expected_ = true;
+                return *this;
+            }
+
+            // Median duration of an iteration for each input size, and of the cold samples with coldCache()
+            const std::vector<std::pair<size_t, Duration>>& getPoints() const { return points_; }
+            const std::vector<std::pair<size_t, Duration>>& getColdPoints() const { return cold_points_; }
+            const ComplexityFit& getFit() const { return fit_; }
+
+            virtual std::string getReport() const override {
+                std::ostringstream oss;
+                oss << ranges_.size() << " input sizes from " << ranges_.front() << " to " << ranges_.back()
+                    << ", best fit " << fit_.complexity << " (RMS " << fit_.rms * 100. << "%)";
+                for (size_t index = 0; index < cold_points_.size() && index < points_.size(); ++index) {
+                    const auto warm = points_[index].second.count();
+                    oss << (index == 0 ? ", cold x" : " x") << (warm > 0. ? cold_points_[index].second.count() / warm : 0.)
+                        << " warm (n=" << cold_points_[index].first << ")";
+                }
+                return oss.str();
+            }
+
+        protected:
+
+            virtual void run_private() override {
+                auto start = std::chrono::high_resolution_clock::now();
+                points_.clear();
+                cold_points_.clear();
+                fit_ = {};
+                run_guarded([this]() {
+                    const BenchmarkEnvironment environment;
+                    std::vector<std::pair<double, double>> points;
+                    for (auto range : ranges_) {
+                        measure(range);
+                        measure_cold(range);
+                        points_.emplace_back(range, getMedian());
+                        if (!cold_samples_.empty()) {
+                            cold_points_.emplace_back(range, getColdMedian());
+                        }
+                        points.emplace_back(static_cast<double>(range), getMedian().count());
+                    }
+                    fit_ = best_fit_complexity(points);
+                    if (has_expected_) {
+                        std::ostringstream oss;
+                        oss << "Expect complexity of at most " << expected_ << " (RMS " << fit_.rms * 100. << "%)";
+                        FailureTest(fit_.complexity <= expected_, fit_.complexity, expected_, FailureType::equal, oss.str(), {});
+                    }
+                });
+                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+            }
+
+        private:
+
+            std::vector<size_t> ranges_;
+            std::vector<std::pair<size_t, Duration>> points_;
+            std::vector<std::pair<size_t, Duration>> cold_points_;
+            ComplexityFit fit_;
+            Complexity expected_ = O_N2;
+            bool has_expected_ = false;
+        };
+
+        // Scaling of a threaded benchmark for a given number of threads
+        struct ThreadScaling {
+            size_t threads = 0;
+            Duration latency = Duration{ 0 }; // median duration of an iteration seen by one thread
+            double throughput = 0.;           // body calls per second, all threads together
+            double efficiency = 0.;           // throughput / (threads * single thread throughput)
+        };
+
+        // This class runs a benchmark body on 1 to max_threads threads at once (doubling the count each step)
+        // The threads are reused by every sample of a step, start each sample together and get their index from BenchmarkState::getThreadIndex()
+        // Cold samples (coldCache()) aren't supported : the caches of the threads can't be evicted apart
+        class ThreadedBenchmark : public Benchmark {
+        public:
+
+            ThreadedBenchmark(const std::string& label, BenchmarkFunctor&& func, size_t max_threads, size_t samples)
+                : Benchmark{ label, std::move(func), samples, 0 }
+            {
+                max_threads = std::max<size_t>(max_threads, 1);
+                for (size_t threads = 1; threads < max_threads; threads *= 2) {
+                    thread_counts_.push_back(threads);
+                }
+                thread_counts_.push_back(max_threads);
+            }
+
+            const std::vector<ThreadScaling>& getScaling() const { return scaling_; }
+
+            // Scaling table, one line per thread count
+            virtual std::string getReport() const override {
+                std::ostringstream oss;
+                oss << iterations_ << " iterations per thread";
+                for (const auto& scaling : scaling_) {
+                    oss << "\n\t\t\t" << scaling.threads << " threads: latency " << scaling.latency.count() << " ms/iter, throughput "
+                        << scaling.throughput << " calls/s, efficiency " << scaling.efficiency * 100. << "%";
+                }
+                return oss.str();
+            }
+
+        protected:
+
+            virtual void run_private() override {
+                auto start = std::chrono::high_resolution_clock::now();
+                scaling_.clear();
+                run_guarded([this]() {
+                    if (cold_cache_)
+                        throw std::logic_error{ "coldCache() isn't supported by threaded benchmarks" };
+                    const BenchmarkEnvironment environment;
+                    BenchmarkState state;
+                    benchmark_holder_(state);
+                    if (calibrate_) {
+                        calibrate(0);
+                    }
+                    for (auto threads : thread_counts_) {
+                        scaling_.push_back(measure_threads(threads));
+                        // 0 if the single thread throughput couldn't be measured (empty body or coarse clock)
+                        const auto single_thread = scaling_.front().throughput;
+                        scaling_.back().efficiency = single_thread > 0. ? scaling_.back().throughput / (static_cast<double>(threads) * single_thread) : 0.;
+                    }
+                });
+                exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+            }
+
+        private:
+
+            ThreadScaling measure_threads(size_t threads) {
+                std::vector<double> walls;
+                std::vector<double> latencies;
+                // The workers are started once for all the samples : their creation stays out of the timed region
+                // Each sample starts when this thread joins the start barrier and ends at the end barrier
+                Barrier start_barrier{ threads + 1 };
+                Barrier end_barrier{ threads + 1 };
+                std::atomic<bool> stop{ false };
+                std::vector<std::chrono::high_resolution_clock::time_point> starts(threads), ends(threads);
+                std::vector<Duration> elapsed(threads);
+                std::vector<std::exception_ptr> errors(threads);
+                std::vector<std::thread> workers;
+                for (size_t index = 0; index < threads; ++index) {
+                    workers.emplace_back([&, index]() {
+                        current_test() = this;
+                        for (;;) {
+                            start_barrier.wait();
+                            if (stop)
+                                return;
+                            BenchmarkState state{ 0, index, threads };
+                            starts[index] = std::chrono::high_resolution_clock::now();
+                            try {
+                                for (size_t i = 0; i < iterations_; ++i) {
+                                    benchmark_holder_(state);
+                                }
+                            }
+                            catch (...) {
+                                errors[index] = std::current_exception();
+                            }
+                            ends[index] = std::chrono::high_resolution_clock::now();
+                            elapsed[index] = ends[index] - starts[index] - state.getPausedTime();
+                            end_barrier.wait();
+                        }
+                    });
+                }
+                std::exception_ptr error;
+                for (size_t sample = 0; sample < samples_count_; ++sample) {
+                    start_barrier.wait();
+                    end_barrier.wait();
+                    for (const auto& worker_error : errors) {
+                        if (worker_error && !error) error = worker_error;
+                    }
+                    if (error)
+                        break;
+                    const Duration wall = *std::max_element(ends.begin(), ends.end()) - *std::min_element(starts.begin(), starts.end());
+                    walls.push_back(wall.count());
+                    for (const auto& duration : elapsed) {
+                        latencies.push_back(duration.count() / static_cast<double>(iterations_));
+                    }
+                }
+                stop = true;
+                start_barrier.wait();
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+                if (error)
+                    std::rethrow_exception(error);
+                ThreadScaling scaling;
+                scaling.threads = threads;
+                scaling.latency = Duration{ median(latencies) };
+                const auto wall_ms = median(walls);
+                scaling.throughput = wall_ms > 0. ? static_cast<double>(threads * iterations_) * 1000. / wall_ms : 0.;
+                return scaling;
+            }
+
+            std::vector<size_t> thread_counts_;
+            std::vector<ThreadScaling> scaling_;
+        };
+
+        // POD containing informations about a test
+        using TestInfo = std::reference_wrapper<const Test>;
+
+        // Interface for making an observer
+        class IRegistryObserver {
+        public:
+            virtual void update(TestInfo infos) const = 0;
+        };
+
+        // Implementation of the observable part of the DP observer
+        class IRegistryObservable {
+        public:
+            void notify(TestInfo infos) const {
+                for (auto& observer : list_observers_) {
+                    observer->update(infos);
+                }
+            }
+            void addObserver(const std::shared_ptr<IRegistryObserver>& observer) { list_observers_.insert(observer); }
+            void removeObserver(const std::shared_ptr<IRegistryObserver>& observer) { list_observers_.erase(observer); }
         private:
             std::set<std::shared_ptr<IRegistryObserver>> list_observers_;
         };
@@ -654,114 +3674,248 @@ namespace H2OFastTests {
 
         };
 
-        RegistryStorage& get_registry() {
-            static RegistryStorage registry;
-            return registry;
-        }
+        H2OFT_DECL RegistryStorage& get_registry();
 
-        // Manage a registry in a static context
-        template<class ScenarioName>
-        class RegistryManager : public IRegistryObservable {
-        public:
+        class ScenarioRegistry;
 
-            using FeederFunctor = std::function<void(void)>;
+        // Every scenario registered by register_scenario, in registration order
+        H2OFT_DECL std::vector<ScenarioRegistry*>& get_scenarios();
 
-            RegistryManager(FeederFunctor feeder)
-                : run_(false), exec_time_ms_accumulator_(Duration{ 0 }) {
-                feeder();
+        // Tests and results of a scenario : the part of RegistryManager which doesn't depend on the scenario type
+        // Running the tests is compiled once in the library with H2OFT_SEPARATE_COMPILATION
+        class ScenarioRegistry : public IRegistryObservable {
+        public:
+
+            ScenarioRegistry(std::type_index index, const std::string& name)
+                : index_(index), name_(name), scenario_id_(get_string_pool().intern(name)), run_(false), prerequisites_failed_(false), exec_time_ms_accumulator_(Duration{ 0 }) {
+                get_scenarios().push_back(this);
             }
 
             //Recursive variadic to iterate over the test pack
-            void add_test(Test&& test) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(test));
+            Test& add_test(Test&& test) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<Test>(std::move(test)));
+                return *tests.back();
             }
 
-            void add_test(TestFunctor&& func) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(make_test(std::move(func))));
+            Test& add_test(TestFunctor&& func) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::move(make_test(std::move(func))));
+                return *tests.back();
             }
 
-            void add_test(const std::string& label, TestFunctor&& func) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(make_test(label, std::move(func))));
+            Test& add_test(const std::string& label, TestFunctor&& func) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::move(make_test(label, std::move(func))));
+                return *tests.back();
             }
             void skip_test(TestFunctor&& func) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(make_skipped_test(std::move(func))));
+                get_registry().getTests(index_).push_back(std::move(make_skipped_test(std::move(func))));
             }
 
             void skip_test(const std::string& label, TestFunctor&& func) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(make_skipped_test(label, std::move(func))));
+                get_registry().getTests(index_).push_back(std::move(make_skipped_test(label, std::move(func))));
             }
 
             void skip_test(const std::string& reason, const std::string& label, TestFunctor&& func) {
-                get_registry().getTests(type_helper<ScenarioName>::type_index()).push_back(std::move(make_skipped_test(reason, label, std::move(func))));
+                get_registry().getTests(index_).push_back(std::move(make_skipped_test(reason, label, std::move(func))));
+            }
+
+            // samples : number of timed samples, iterations : body calls per sample (0 to calibrate)
+            Benchmark& add_benchmark(const std::string& label, TestFunctor&& func, size_t samples = 30, size_t iterations = 0) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::move(make_benchmark(label, std::move(func), samples, iterations)));
+                return static_cast<Benchmark&>(*tests.back());
+            }
+
+            Benchmark& add_benchmark(const std::string& label, BenchmarkFunctor&& func, size_t samples = 30, size_t iterations = 0) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::move(make_benchmark(label, std::move(func), samples, iterations)));
+                return static_cast<Benchmark&>(*tests.back());
+            }
+
+            // Sweep the input size from range_min to range_max, multiplied by multiplier at each step
+            ComplexityBenchmark& add_complexity_benchmark(const std::string& label, BenchmarkFunctor&& func, size_t range_min, size_t range_max, size_t multiplier = 2, size_t samples = 10) {
+                auto benchmark = std::make_unique<ComplexityBenchmark>(label, std::move(func), range_min, range_max, multiplier, samples);
+                auto& result = *benchmark;
+                get_registry().getTests(index_).push_back(std::move(benchmark));
+                return result;
+            }
+
+            // Run the body on threads threads at once, iterations times per thread
+            StressTest& add_stress_test(const std::string& label, size_t threads, size_t iterations, StressFunctor&& func) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<StressTest>(label, threads, iterations, std::move(func)));
+                return static_cast<StressTest&>(*tests.back());
+            }
+
+            StressTest& add_stress_test(const std::string& label, size_t threads, size_t iterations, TestFunctor&& func) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<StressTest>(label, threads, iterations, std::move(func)));
+                return static_cast<StressTest&>(*tests.back());
+            }
+
+            // Replay the files of the corpus directory (no corpus if empty), or fuzz from them with Options::fuzz
+            FuzzTest& add_fuzz_test(const std::string& label, FuzzFunctor&& func, const std::string& corpus = {}) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<FuzzTest>(label, std::move(func), corpus));
+                return static_cast<FuzzTest&>(*tests.back());
+            }
+
+            // Run the body on each row of the case file, parsed lazily from its mapping (DataDrivenTest)
+            DataDrivenTest& add_data_driven_test(const std::string& label, const std::string& path, DataRowFunctor&& func) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<DataDrivenTest>(label, path, std::move(func)));
+                return static_cast<DataDrivenTest&>(*tests.back());
+            }
+
+            // The body returns an AsyncTask coroutine (C++20) or a future-like object (wait_for() and get())
+            // It fails with an error if not finished after timeout
+            // The async tests run after the other tests of the scenario, concurrently (see Options::async_threads)
+            template<class Functor>
+            AsyncTest& add_async_test(const std::string& label, Functor&& func, Duration timeout = Duration{ 10000 }) {
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<AsyncTest>(label, std::forward<Functor>(func), timeout));
+                return static_cast<AsyncTest&>(*tests.back());
+            }
+
+            // Run the body on 1 to max_threads threads at once (0 for the hardware concurrency)
+            ThreadedBenchmark& add_threaded_benchmark(const std::string& label, BenchmarkFunctor&& func, size_t max_threads = 0, size_t samples = 10) {
+                if (max_threads == 0) {
+                    max_threads = std::thread::hardware_concurrency();
+                }
+                auto& tests = get_registry().getTests(index_);
+                tests.push_back(std::make_unique<ThreadedBenchmark>(label, std::move(func), max_threads, samples));
+                return static_cast<ThreadedBenchmark&>(*tests.back());
             }
 
             void set_up(SetUpFunctor&& func) {
-                get_registry().getSetUp(type_helper<ScenarioName>::type_index()) = std::move(func);
+                get_registry().getSetUp(index_) = std::move(func);
             }
 
             void tear_down(TearDownFunctor&& func) {
-                get_registry().getTearDown(type_helper<ScenarioName>::type_index()) = std::move(func);
+                get_registry().getTearDown(index_) = std::move(func);
+            }
+
+            // The scenario only runs once the scenario with this name passed, its tests are skipped otherwise (run_all_scenarios)
+            void depends_on(const std::string& scenario) {
+                prerequisites_.push_back(scenario);
             }
 
             // Run all the tests
-            void run_tests() {
-                const auto& setup = get_registry().getSetUp(type_helper<ScenarioName>::type_index());
-                const auto& teardown = get_registry().getTearDown(type_helper<ScenarioName>::type_index());
-                auto& tests = get_registry().getTests(type_helper<ScenarioName>::type_index());
-                for (auto& test : tests) {
-                    test->run(setup, teardown);
-                    exec_time_ms_accumulator_ += test->getExecTimeMs();
-                    notify(TestInfo{ *test });
-                    switch (test->getStatus()) {
-                    case Test::Status::PASSED:
-                        tests_passed_.push_back(std::cref(*test));
-                        break;
-                    case Test::Status::FAILED:
-                        tests_failed_.push_back(std::cref(*test));
-                        break;
-                    case Test::Status::SKIPPED:
-                        tests_skipped_.push_back(std::cref(*test));
-                        break;
-                    case Test::Status::ERROR:
-                        tests_with_error_.push_back(std::cref(*test));
-                        break;
-                    default: break;
-                    }
-                }
-                run_ = true;
+            void run_tests();
+
+            // Skip all the tests with the reason, as if the scenario was run
+            void skip_tests(const std::string& reason);
+
+            // Mark all the tests cancelled, as if the scenario was run
+            void cancel_tests();
+
+            const std::string& getName() const { return name_; }
+            const std::vector<std::string>& getPrerequisites() const { return prerequisites_; }
+            bool hasRun() const { return run_; }
+            // Run with all its prerequisites and tests passing (skipped tests aside), and no unowned failure
+            bool hasPassed() const {
+                return run_ && !prerequisites_failed_ && results_.count(Test::Status::FAILED) == 0 && results_.count(Test::Status::ERROR) == 0 && results_.count(Test::Status::CANCELLED) == 0 &&
+                    unowned_failures_.empty();
             }
 
-            // describe test suite
-            virtual void describe() {}
+        private:
+
+            // Tests in run order : the prerequisites of a test run before it
+            static std::vector<Test*> order_by_prerequisites(const std::vector<Test*>& tests);
+
+            // Mark the test skipped without running it
+            static void skip(Test& test, const std::string& reason);
+
+            // Mark the test cancelled without running it
+            static void cancel(Test& test);
+
+            // Publish the start of the scenario in the progress file, if any
+            void publish_progress(size_t tests);
+
+            void record(const Test& test);
+
+            static std::string replay_info(uint64_t seed, size_t iteration);
+
+            static void annotate_failure(Test& test, const std::string& info);
+
+            // Run the repeats of a test on Options::jobs threads, each repeat on its own clone
+            // The test keeps the result of its first failing iteration, or of its last run
+            // A test that can't be cloned runs its repeats sequentially and stops at its first failing iteration
+            void run_repeated(Test& test, const SetUpFunctor& setup, const TearDownFunctor& teardown, uint64_t seed);
+
+        public:
 
             // Get informations
 
-            size_t getPassedCount() const { return run_ ? tests_passed_.size() : 0; }
-            const std::vector<std::reference_wrapper<const Test>>& getPassedTests() const { return tests_passed_; }
+            size_t getPassedCount() const { return run_ ? results_.count(Test::Status::PASSED) : 0; }
+            TestView getPassedTests() const { return TestView{ results_, Test::Status::PASSED }; }
 
-            size_t getFailedCount() const { return run_ ? tests_failed_.size() : 0; }
-            const std::vector<std::reference_wrapper<const Test >>& getFailedTests() const { return tests_failed_; }
+            size_t getFailedCount() const { return run_ ? results_.count(Test::Status::FAILED) : 0; }
+            TestView getFailedTests() const { return TestView{ results_, Test::Status::FAILED }; }
 
-            size_t getSkippedCount() const { return run_ ? tests_skipped_.size() : 0; }
-            const std::vector<std::reference_wrapper<const Test>>& getSkippedTests() const { return tests_skipped_; }
+            size_t getSkippedCount() const { return run_ ? results_.count(Test::Status::SKIPPED) : 0; }
+            TestView getSkippedTests() const { return TestView{ results_, Test::Status::SKIPPED }; }
 
-            size_t getWithErrorCount() const { return run_ ? tests_with_error_.size() : 0; }
-            const std::vector<std::reference_wrapper<const Test>>& getWithErrorTests() const { return tests_with_error_; }
+            size_t getWithErrorCount() const { return run_ ? results_.count(Test::Status::ERROR) : 0; }
+            TestView getWithErrorTests() const { return TestView{ results_, Test::Status::ERROR }; }
 
-            size_t getAllTestsCount() const { return run_ ? get_registry().getTests(type_helper<ScenarioName>::type_index()).size() : 0; }
-            const TestList& getAllTests() const { return get_registry().getTests(type_helper<ScenarioName>::type_index()); }
+            size_t getCancelledCount() const { return run_ ? results_.count(Test::Status::CANCELLED) : 0; }
+            TestView getCancelledTests() const { return TestView{ results_, Test::Status::CANCELLED }; }
+
+            // Failures of threads without test raised while the scenario ran, that couldn't be attributed to one of its tests
+            const std::vector<std::string>& getUnownedFailures() const { return unowned_failures_; }
+
+            size_t getAllTestsCount() const { return run_ ? get_registry().getTests(index_).size() : 0; }
+            const TestList& getAllTests() const { return get_registry().getTests(index_); }
+            // Results of the recorded tests, a row per test
+            const ResultTable& getResults() const { return results_; }
             Duration getAllTestsExecTimeMs() const { return run_ ? exec_time_ms_accumulator_ : Duration{ 0 }; }
+            Duration getAllTestsSetUpTimeMs() const { return run_ ? setup_time_ms_accumulator_ : Duration{ 0 }; }
+            Duration getAllTestsTearDownTimeMs() const { return run_ ? teardown_time_ms_accumulator_ : Duration{ 0 }; }
+            // Timings of the scoped timers of all the tests, by name
+            std::map<std::string, Timing> getAllTestsTimings() const;
 
         private:
 
+            std::type_index index_;
+            std::string name_;
+            uint32_t scenario_id_;
+            std::vector<std::string> prerequisites_;
             bool run_;
+            bool prerequisites_failed_;
             Duration exec_time_ms_accumulator_;
-            std::vector<std::reference_wrapper<const Test>> tests_passed_;
-            std::vector<std::reference_wrapper<const Test>> tests_failed_;
-            std::vector<std::reference_wrapper<const Test>> tests_skipped_;
-            std::vector<std::reference_wrapper<const Test>> tests_with_error_;
+            Duration setup_time_ms_accumulator_{ 0 };
+            Duration teardown_time_ms_accumulator_{ 0 };
+            ResultTable results_;
+            std::vector<std::string> unowned_failures_;
+            ProgressFile::Scenario* progress_ = nullptr;
+
+        };
+
+        // Manage a registry in a static context
+        template<class ScenarioName>
+        class RegistryManager : public ScenarioRegistry {
+        public:
+
+            using FeederFunctor = std::function<void(void)>;
+
+            RegistryManager(FeederFunctor feeder, const std::string& name = type_helper<ScenarioName>::name())
+                : ScenarioRegistry(type_helper<ScenarioName>::type_index(), name) {
+                feeder();
+            }
 
+            // describe test suite
+            virtual void describe() {}
         };
+
+        // Run every registered scenario not run yet on threads workers (0 for the hardware concurrency)
+        // A scenario starts as soon as its prerequisites are done, it's skipped if one of them didn't pass
+        H2OFT_DECL void run_scenarios(size_t threads);
+
+        // Print the results of a scenario (RegistryTraversal_ConsoleIO)
+        H2OFT_DECL void print_summary(const ScenarioRegistry& registry_manager, const std::string& test_name, bool verbose);
     }
 
     /*
@@ -776,6 +3930,64 @@ namespace H2OFastTests {
     using detail::Test;
     using detail::RegistryStorage;
     using detail::IRegistryObserver;
+    using detail::Benchmark;
+    using detail::BenchmarkComparison;
+    using detail::BenchmarkVerdict;
+    using detail::BenchmarkStorage;
+    using detail::BenchmarkState;
+    using detail::BenchmarkEnvironment;
+    using detail::BenchmarkMemory;
+    using detail::coefficient_of_variation;
+    using detail::DoNotOptimize;
+    using detail::ClobberMemory;
+    using detail::Complexity;
+    using detail::ComplexityFit;
+    using detail::ComplexityBenchmark;
+    using detail::ThreadScaling;
+    using detail::ThreadedBenchmark;
+    using detail::Histogram;
+    using detail::test_histogram;
+    using detail::Timing;
+    using detail::ResultTable;
+    using detail::TestView;
+    using detail::get_string_pool;
+    using detail::get_unowned_failures;
+    using detail::ScopedTimer;
+    using detail::Options;
+    using detail::get_options;
+    using detail::ResourceUsage;
+    using detail::FailureSink;
+    using detail::TestThread;
+    using detail::TestClock;
+    using detail::VirtualClock;
+    using detail::StressTest;
+    using detail::FuzzTest;
+    using detail::DataRow;
+    using detail::DataDrivenTest;
+    using detail::test_seed;
+    using detail::CancellationToken;
+    using detail::ImpactIndex;
+    using detail::ProgressFile;
+    using detail::TraceSpan;
+    using detail::read_progress;
+    using detail::get_cancellation_token;
+    using detail::is_cancelled;
+    using detail::stress_point;
+    using detail::AsyncTest;
+#if H2OFT_HAS_COROUTINES
+    using detail::AsyncTask;
+    using detail::async_sleep;
+#if H2OFT_OS_LINUX
+    using detail::async_wait;
+    using detail::async_readable;
+    using detail::async_writable;
+#endif
+#endif
+    using detail::O_1;
+    using detail::O_LogN;
+    using detail::O_N;
+    using detail::O_NLogN;
+    using detail::O_N2;
     template<class ScenarioName>
     using RegistryManager = detail::RegistryManager<ScenarioName>;
 
@@ -783,6 +3995,17 @@ namespace H2OFastTests {
     namespace Asserter {
         using detail::AsserterExpression;
         using detail::AssertThat;
+
+        // Matchers for AsserterExpression::matches
+        using detail::equalTo;
+        using detail::allOf;
+        using detail::anyOf;
+        using detail::not_;
+        using detail::inRange;
+        using detail::near;
+        using detail::hasSize;
+        using detail::contains;
+        using detail::matchesPredicate;
     }
 
     // Interface to Implement to access access a registry information
@@ -804,60 +4027,20 @@ namespace H2OFastTests {
     public:
         RegistryTraversal_ConsoleIO(const RegistryManager<ScenarioName>& registry) : IRegistryTraversal<ScenarioName>(registry) {}
         void print(bool verbose) const {
-            auto& registry_manager = this->getRegistryManager();
-            const auto test_name = std::string{ H2OFastTests::detail::type_helper<ScenarioName>::name() };
-            ColoredPrintf(COLOR_CYAN, "UNIT TEST SUMMARY [%s] [%.6f ms] : \n", test_name.substr(test_name.find(' ') + 1).c_str(), registry_manager.getAllTestsExecTimeMs().count());
-
-            if (registry_manager.getPassedCount() > 0) {
-                ColoredPrintf(COLOR_GREEN, "\tPASSED: %d/%d\n", registry_manager.getPassedCount(), registry_manager.getAllTestsCount());
-                if (verbose) {
-                    for (const auto& test : registry_manager.getPassedTests()) {
-                        ColoredPrintf(COLOR_GREEN, "\t\t[%s] [%.6f ms]\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count());
-                    }
-                }
-            }
-
-            if (registry_manager.getFailedCount() > 0) {
-                ColoredPrintf(COLOR_RED, "\tFAILED: %d/%d\n", registry_manager.getFailedCount(), registry_manager.getAllTestsCount());
-                // Always print failed tests
-                for (const auto& test : registry_manager.getFailedTests()) {
-                    ColoredPrintf(COLOR_RED, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getFailureReason().c_str());
-                }
-            }
-
-            if (registry_manager.getSkippedCount() > 0) {
-                ColoredPrintf(COLOR_YELLOW, "\tSKIPPED: %d/%d\n", registry_manager.getSkippedCount(), registry_manager.getAllTestsCount());
-                if (verbose) {
-                    for (const auto& test : registry_manager.getSkippedTests()) {
-                        ColoredPrintf(COLOR_YELLOW, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getSkippedReason().c_str());
-                    }
-                }
-            }
-
-            if (registry_manager.getWithErrorCount() > 0) {
-                ColoredPrintf(COLOR_PURPLE, "\tERRORS: %d/%d\n", registry_manager.getWithErrorCount(), registry_manager.getAllTestsCount());
-                // Always print error tests
-                for (const auto& test : registry_manager.getWithErrorTests()) {
-                    ColoredPrintf(COLOR_PURPLE, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getError().c_str());
-                }
-            }
+            detail::print_summary(this->getRegistryManager(), H2OFastTests::detail::type_helper<ScenarioName>::name(), verbose);
         }
     };
 
     // Observer impl example
     class ConsoleIO_Observer : public IRegistryObserver {
-        virtual void update(TestInfo infos) const override {
-            std::cout << (infos.get().getStatus() == Test::Status::SKIPPED ? "SKIPPING TEST [" : "RUNNING TEST [")
-                << infos.get().getLabel(false) << "] [" << infos.get().getExecTimeMs().count() << "ms]:" << std::endl
-                << "Status: " << infos.get().getStatus() << std::endl;
-        }
+        virtual void update(TestInfo infos) const override;
     };
 }
 
 //Helper macros to use the unit test suit
 #define register_scenario(ScenarioName) \
-    struct ScenarioName : H2OFastTests::template RegistryManager<ScenarioName> { \
-        ScenarioName(H2OFastTests::template RegistryManager<ScenarioName>::FeederFunctor feeder); \
+    struct ScenarioName : H2OFastTests::RegistryManager<ScenarioName> { \
+        ScenarioName(H2OFastTests::RegistryManager<ScenarioName>::FeederFunctor feeder); \
         virtual void describe(); \
     }; \
     static ScenarioName ScenarioName ## _registry_manager{ []() { \
@@ -865,8 +4048,8 @@ namespace H2OFastTests {
         H2OFastTests::detail::get_registry().getAllSetUps().emplace(H2OFastTests::detail::template type_helper<ScenarioName>::type_index(), [](){}); \
         H2OFastTests::detail::get_registry().getAllTearDowns().emplace(H2OFastTests::detail::template type_helper<ScenarioName>::type_index(), [](){}); \
     } }; \
-    ScenarioName::ScenarioName(H2OFastTests::template RegistryManager<ScenarioName>::FeederFunctor feeder) \
-        : RegistryManager<ScenarioName>{ feeder } { \
+    ScenarioName::ScenarioName(H2OFastTests::RegistryManager<ScenarioName>::FeederFunctor feeder) \
+        : RegistryManager<ScenarioName>{ feeder, #ScenarioName } { \
         describe(); \
     } \
     void ScenarioName::describe()
@@ -874,6 +4057,9 @@ namespace H2OFastTests {
 #define run_scenario(ScenarioName) \
     ScenarioName ## _registry_manager.run_tests();
 
+#define run_all_scenarios() \
+    H2OFastTests::detail::run_scenarios(H2OFastTests::get_options().scenario_jobs)
+
 #define register_observer(ScenarioName, class_name) \
     ScenarioName ## _registry_manager.addObserver(std::make_shared<class_name>())
 
@@ -886,9 +4072,31 @@ namespace H2OFastTests {
 #define print_result(ScenarioName) \
     H2OFastTests::RegistryTraversal_ConsoleIO<ScenarioName>(ScenarioName ## _registry_manager).print(false)
 
+#define load_benchmark_baseline(path) \
+    H2OFastTests::detail::get_benchmark_storage().loadBaseline(path)
+
+#define save_benchmark_baseline(path) \
+    H2OFastTests::detail::get_benchmark_storage().saveRun(path)
+
+#define pin_benchmarks(...) \
+    H2OFastTests::detail::get_benchmark_storage().setCpuAffinity({ __VA_ARGS__ })
+
+#define H2OFT_CONCAT_IMPL(a, b) a##b
+#define H2OFT_CONCAT(a, b) H2OFT_CONCAT_IMPL(a, b)
+
+#define scoped_timer(name) \
+    H2OFastTests::detail::ScopedTimer H2OFT_CONCAT(h2oft_scoped_timer_, __LINE__){ name }
+
+#define save_trace(path) \
+    H2OFastTests::detail::get_trace_storage().save(path)
+
 #define line_info() \
     H2OFastTests::LineInfo(__FILE__, "", __LINE__)
 #define line_info_f() \
     H2OFastTests::LineInfo(__FILE__, __FUNCTION__, __LINE__)
 
+#if !defined(H2OFT_SEPARATE_COMPILATION)
+#include "H2OFastTests_impl.hpp"
+#endif
+
 #endif
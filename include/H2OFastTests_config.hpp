@@ -13,6 +13,9 @@
 #ifndef H2OFASTTESTS_CONFIG_H
 #define H2OFASTTESTS_CONFIG_H
 
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -77,12 +80,19 @@
 // gettimeofday().
 # define H2OFT_HAS_GETTIMEOFDAY_ 1
 
+# include <cxxabi.h>  // NOLINT
+# include <dlfcn.h>  // NOLINT
 # include <fcntl.h>  // NOLINT
 # include <limits.h>  // NOLINT
+# include <link.h>  // NOLINT
 # include <sched.h>  // NOLINT
 // Declares vsnprintf().  This header is not available on Windows.
 # include <strings.h>  // NOLINT
+# include <sys/epoll.h>  // NOLINT
+# include <sys/eventfd.h>  // NOLINT
 # include <sys/mman.h>  // NOLINT
+# include <sys/resource.h>  // NOLINT
+# include <sys/stat.h>  // NOLINT
 # include <sys/time.h>  // NOLINT
 # include <unistd.h>  // NOLINT
 # include <string>
@@ -152,6 +162,29 @@ struct _RTL_CRITICAL_SECTION;
 # include <strings.h>
 #endif  // H2OFT_OS_WINDOWS
 
+// C++20 coroutines are used by the async tests when available.
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+# if __has_include(<coroutine>)
+#  define H2OFT_HAS_COROUTINES 1
+# endif
+#endif
+
+// H2OFT_SEPARATE_COMPILATION : the runtime is compiled once in the H2OFastTests library
+// instead of being defined inline in every translation unit including H2OFastTests.hpp.
+#if defined(H2OFT_SEPARATE_COMPILATION)
+# define H2OFT_DECL
+#else
+# define H2OFT_DECL inline
+#endif
+
+// H2OFT_NO_INSTRUMENT : functions reachable from the -finstrument-functions hook (test impact analysis),
+// instrumenting them would re-enter the hook before it guards itself.
+#if defined(__GNUC__) || defined(__clang__)
+# define H2OFT_NO_INSTRUMENT __attribute__((no_instrument_function))
+#else
+# define H2OFT_NO_INSTRUMENT
+#endif
+
 #if _MSC_VER >= 1500
 # define H2OFT_DISABLE_MSC_WARNINGS_PUSH_(warnings) \
     __pragma(warning(push))                        \
@@ -211,173 +244,17 @@ enum H2OFTColor {
 
 #if H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE && \
     !H2OFT_OS_WINDOWS_PHONE && !H2OFT_OS_WINDOWS_RT
-
-// Returns the character attribute for the given color.
-WORD GetForegroundColorAttribute(H2OFTColor color) {
-    switch (color) {
-    case COLOR_RED:    return FOREGROUND_RED;
-    case COLOR_GREEN:  return FOREGROUND_GREEN;
-    case COLOR_YELLOW: return FOREGROUND_RED | FOREGROUND_GREEN;
-    case COLOR_BLUE:   return FOREGROUND_BLUE;
-    case COLOR_PURPLE: return FOREGROUND_RED | FOREGROUND_BLUE;
-    case COLOR_CYAN:   return FOREGROUND_BLUE | FOREGROUND_GREEN;
-    default:           return 0;
-    }
-}
-
-/*
 // Returns the character attribute for the given color.
-WORD GetBackgroundColorAttribute(H2OFTColor color) {
-switch (color) {
-case COLOR_RED:    return BACKGROUND_RED;
-case COLOR_BLUE:   return BACKGROUND_BLUE;
-case COLOR_GREEN:  return BACKGROUND_GREEN;
-case COLOR_YELLOW: return BACKGROUND_RED | BACKGROUND_GREEN;
-case COLOR_PURPLE: return BACKGROUND_RED | BACKGROUND_BLUE;
-case COLOR_CYAN:   return BACKGROUND_BLUE | BACKGROUND_GREEN;
-default:           return 0;
-}
-}
-*/
-
+H2OFT_DECL WORD GetForegroundColorAttribute(H2OFTColor color);
 #else
-/*
-Black       0;30     Dark Gray     1;30
-Blue        0;34     Light Blue    1;34
-Green       0;32     Light Green   1;32
-Cyan        0;36     Light Cyan    1;36
-Red         0;31     Light Red     1;31
-Purple      0;35     Light Purple  1;35
-Brown       0;33     Yellow        1;33
-Light Gray  0;37     White         1;37
-*/
 // Returns the ANSI color code for the given color.
-const char* GetAnsiColorCode(H2OFTColor color) {
-    switch (color) {
-    case COLOR_RED:     return "1";
-    case COLOR_GREEN:   return "2";
-    case COLOR_YELLOW:  return "3";
-    case COLOR_BLUE:    return "4";
-    case COLOR_PURPLE:  return "5";
-    case COLOR_CYAN:    return "6";
-    default:            return "7";
-    };
-}
-
+H2OFT_DECL const char* GetAnsiColorCode(H2OFTColor color);
 #endif  // H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE
 
 // Returns true iff Google Test should use colors in the output.
-bool ShouldUseColor(bool stdout_is_tty) {
-    const std::string H2OFT_color = "auto";
-
-    if (H2OFT_color == "auto") {
-#if H2OFT_OS_WINDOWS
-        // On Windows the TERM variable is usually not set, but the
-        // console there does support colors.
-        return stdout_is_tty;
-#else
-#   if H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_WINDOWS_PHONE | H2OFT_OS_WINDOWS_RT
-        // We are on Windows CE, which has no environment variables.
-        const std::string term = NULL;
-#   elif defined(__BORLANDC__) || defined(__SunOS_5_8) || defined(__SunOS_5_9)
-        // Environment variables which we programmatically clear will be set to the
-        // empty string rather than unset (NULL).  Handle that case.
-        const char* const env = getenv("TERM");
-        const std::string term = std::string{ (env != NULL && env[0] != '\0') ? env : NULL };
-#   else
-        char* buffer = nullptr;
-        size_t sz = 0;
-        if (_dupenv_s(&buffer, &sz, "TERM") == 0 && buffer == nullptr)
-        {
-            return stdout_is_tty;
-        }
-        const std::string term = std::string{ buffer };
-#       define FREE_BUFFER free(buffer);
-#   endif
-        
-        // On non-Windows platforms, we rely on the TERM variable.
-        const bool term_supports_color =
-            term == "xterm" ||
-            term == "xterm-color" ||
-            term == "xterm-256color" ||
-            term == "screen" ||
-            term == "screen-256color" ||
-            term == "tmux" ||
-            term == "tmux-256color" ||
-            term == "rxvt-unicode" ||
-            term == "rxvt-unicode-256color" ||
-            term == "linux" ||
-            term == "cygwin";
-        
-#       ifdef FREE_BUFFER
-        FREE_BUFFER
-#       undef FREE_BUFFER
-#       endif
-
-
-        return stdout_is_tty && term_supports_color;
-#   endif  // H2OFT_OS_WINDOWS
-    }
-
-    return H2OFT_color == "yes" ||
-        H2OFT_color == "true" ||
-        H2OFT_color == "t" ||
-        H2OFT_color == "1";
-    // We take "yes", "true", "t", and "1" as meaning "yes".  If the
-    // value is neither one of these nor "auto", we treat it as "no" to
-    // be conservative.
-}
-
-// Helpers for printing colored strings to stdout. Note that on Windows, we
-// cannot simply emit special characters and have the terminal change colors.
-// This routine must actually emit the characters rather than return a string
-// that would be colored when printed, as can be done on Linux.
-void ColoredPrintf(H2OFTColor color, const char* fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
-
-#if H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_SYMBIAN || H2OFT_OS_ZOS || \
-    H2OFT_OS_IOS || H2OFT_OS_WINDOWS_PHONE || H2OFT_OS_WINDOWS_RT
-    const bool use_color = AlwaysFalse();
-#else
-    static const bool in_color_mode =
-        ShouldUseColor(posix::IsATTY(posix::FileNo(stdout)) != 0);
-    const bool use_color = in_color_mode && (color != COLOR_DEFAULT);
-#endif  // H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_SYMBIAN || H2OFT_OS_ZOS
-    // The '!= 0' comparison is necessary to satisfy MSVC 7.1.
-
-    if (!use_color) {
-        vprintf(fmt, args);
-        va_end(args);
-        return;
-    }
+H2OFT_DECL bool ShouldUseColor(bool stdout_is_tty);
 
-#if H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE && \
-    !H2OFT_OS_WINDOWS_PHONE && !H2OFT_OS_WINDOWS_RT
-    const HANDLE stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-
-    // Gets the current text color.
-    CONSOLE_SCREEN_BUFFER_INFO buffer_info;
-    GetConsoleScreenBufferInfo(stdout_handle, &buffer_info);
-    const WORD old_color_attrs = buffer_info.wAttributes;
-
-    // We need to flush the stream buffers into the console before each
-    // SetConsoleTextAttribute call lest it affect the text that is already
-    // printed but has not yet reached the console.
-    fflush(stdout);
-    SetConsoleTextAttribute(stdout_handle,
-        GetForegroundColorAttribute(color) | FOREGROUND_INTENSITY);
-    vprintf(fmt, args);
-
-    fflush(stdout);
-    // Restores the text color.
-    SetConsoleTextAttribute(stdout_handle, old_color_attrs);
-#else
-    printf("\033[0;3%sm", GetAnsiColorCode(color));
-    vprintf(fmt, args);
-    printf("\033[m");  // Resets the terminal to default.
-#endif  // H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE
-    va_end(args);
-}
+// Prints a colored string to stdout (defined with the runtime in H2OFastTests_impl.hpp).
+H2OFT_DECL void ColoredPrintf(H2OFTColor color, const char* fmt, ...);
 
 #endif
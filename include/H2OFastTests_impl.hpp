@@ -0,0 +1,3033 @@
+/*
+ *
+ *  (C) Copyright 2016 Michaël Roynard
+ *
+ *  Distributed under the MIT License, Version 1.0. (See accompanying
+ *  file LICENSE or copy at https://opensource.org/licenses/MIT)
+ *
+ *  See https://github.com/dutiona/H2OFastTests for documentation.
+ */
+
+#pragma once
+
+#ifndef H2OFASTTESTS_IMPL_H
+#define H2OFASTTESTS_IMPL_H
+
+// Non-template runtime of H2OFastTests
+// Included by H2OFastTests.hpp (header-only), or compiled once in src/H2OFastTests.cpp with H2OFT_SEPARATE_COMPILATION
+
+#include "H2OFastTests.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <new>
+#include <unordered_set>
+
+#if H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE && \
+    !H2OFT_OS_WINDOWS_PHONE && !H2OFT_OS_WINDOWS_RT
+
+// Returns the character attribute for the given color.
+H2OFT_DECL WORD GetForegroundColorAttribute(H2OFTColor color) {
+    switch (color) {
+    case COLOR_RED:    return FOREGROUND_RED;
+    case COLOR_GREEN:  return FOREGROUND_GREEN;
+    case COLOR_YELLOW: return FOREGROUND_RED | FOREGROUND_GREEN;
+    case COLOR_BLUE:   return FOREGROUND_BLUE;
+    case COLOR_PURPLE: return FOREGROUND_RED | FOREGROUND_BLUE;
+    case COLOR_CYAN:   return FOREGROUND_BLUE | FOREGROUND_GREEN;
+    default:           return 0;
+    }
+}
+
+/*
+// Returns the character attribute for the given color.
+WORD GetBackgroundColorAttribute(H2OFTColor color) {
+switch (color) {
+case COLOR_RED:    return BACKGROUND_RED;
+case COLOR_BLUE:   return BACKGROUND_BLUE;
+case COLOR_GREEN:  return BACKGROUND_GREEN;
+case COLOR_YELLOW: return BACKGROUND_RED | BACKGROUND_GREEN;
+case COLOR_PURPLE: return BACKGROUND_RED | BACKGROUND_BLUE;
+case COLOR_CYAN:   return BACKGROUND_BLUE | BACKGROUND_GREEN;
+default:           return 0;
+}
+}
+*/
+
+#else
+/*
+Black       0;30     Dark Gray     1;30
+Blue        0;34     Light Blue    1;34
+Green       0;32     Light Green   1;32
+Cyan        0;36     Light Cyan    1;36
+Red         0;31     Light Red     1;31
+Purple      0;35     Light Purple  1;35
+Brown       0;33     Yellow        1;33
+Light Gray  0;37     White         1;37
+*/
+// Returns the ANSI color code for the given color.
+H2OFT_DECL const char* GetAnsiColorCode(H2OFTColor color) {
+    switch (color) {
+    case COLOR_RED:     return "1";
+    case COLOR_GREEN:   return "2";
+    case COLOR_YELLOW:  return "3";
+    case COLOR_BLUE:    return "4";
+    case COLOR_PURPLE:  return "5";
+    case COLOR_CYAN:    return "6";
+    default:            return "7";
+    };
+}
+
+#endif  // H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE
+
+// Returns true iff Google Test should use colors in the output.
+H2OFT_DECL bool ShouldUseColor(bool stdout_is_tty) {
+    const std::string H2OFT_color = "auto";
+
+    if (H2OFT_color == "auto") {
+#if H2OFT_OS_WINDOWS
+        // On Windows the TERM variable is usually not set, but the
+        // console there does support colors.
+        return stdout_is_tty;
+#else
+#   if H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_WINDOWS_PHONE | H2OFT_OS_WINDOWS_RT
+        // We are on Windows CE, which has no environment variables.
+        const std::string term = NULL;
+#   elif defined(__BORLANDC__) || defined(__SunOS_5_8) || defined(__SunOS_5_9)
+        // Environment variables which we programmatically clear will be set to the
+        // empty string rather than unset (NULL).  Handle that case.
+        const char* const env = getenv("TERM");
+        const std::string term = std::string{ (env != NULL && env[0] != '\0') ? env : NULL };
+#   elif defined(_MSC_VER)
+        char* buffer = nullptr;
+        size_t sz = 0;
+        if (_dupenv_s(&buffer, &sz, "TERM") == 0 && buffer == nullptr)
+        {
+            return stdout_is_tty;
+        }
+        const std::string term = std::string{ buffer };
+#       define FREE_BUFFER free(buffer);
+#   else
+        const char* const env = getenv("TERM");
+        if (env == nullptr)
+        {
+            return stdout_is_tty;
+        }
+        const std::string term = std::string{ env };
+#   endif
+        
+        // On non-Windows platforms, we rely on the TERM variable.
+        const bool term_supports_color =
+            term == "xterm" ||
+            term == "xterm-color" ||
+            term == "xterm-256color" ||
+            term == "screen" ||
+            term == "screen-256color" ||
+            term == "tmux" ||
+            term == "tmux-256color" ||
+            term == "rxvt-unicode" ||
+            term == "rxvt-unicode-256color" ||
+            term == "linux" ||
+            term == "cygwin";
+        
+#       ifdef FREE_BUFFER
+        FREE_BUFFER
+#       undef FREE_BUFFER
+#       endif
+
+
+        return stdout_is_tty && term_supports_color;
+#   endif  // H2OFT_OS_WINDOWS
+    }
+
+    return H2OFT_color == "yes" ||
+        H2OFT_color == "true" ||
+        H2OFT_color == "t" ||
+        H2OFT_color == "1";
+    // We take "yes", "true", "t", and "1" as meaning "yes".  If the
+    // value is neither one of these nor "auto", we treat it as "no" to
+    // be conservative.
+}
+
+// Helpers for printing colored strings to stdout. Note that on Windows, we
+// cannot simply emit special characters and have the terminal change colors.
+// This routine must actually emit the characters rather than return a string
+// that would be colored when printed, as can be done on Linux.
+H2OFT_DECL void ColoredPrintf(H2OFTColor color, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+
+#if H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_SYMBIAN || H2OFT_OS_ZOS || \
+    H2OFT_OS_IOS || H2OFT_OS_WINDOWS_PHONE || H2OFT_OS_WINDOWS_RT
+    const bool use_color = AlwaysFalse();
+#else
+    static const bool in_color_mode =
+        ShouldUseColor(posix::IsATTY(posix::FileNo(stdout)) != 0);
+    const bool use_color = in_color_mode && (color != COLOR_DEFAULT);
+#endif  // H2OFT_OS_WINDOWS_MOBILE || H2OFT_OS_SYMBIAN || H2OFT_OS_ZOS
+    // The '!= 0' comparison is necessary to satisfy MSVC 7.1.
+
+    if (!use_color) {
+        vprintf(fmt, args);
+        va_end(args);
+        return;
+    }
+
+#if H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE && \
+    !H2OFT_OS_WINDOWS_PHONE && !H2OFT_OS_WINDOWS_RT
+    const HANDLE stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    // Gets the current text color.
+    CONSOLE_SCREEN_BUFFER_INFO buffer_info;
+    GetConsoleScreenBufferInfo(stdout_handle, &buffer_info);
+    const WORD old_color_attrs = buffer_info.wAttributes;
+
+    // We need to flush the stream buffers into the console before each
+    // SetConsoleTextAttribute call lest it affect the text that is already
+    // printed but has not yet reached the console.
+    fflush(stdout);
+    SetConsoleTextAttribute(stdout_handle,
+        GetForegroundColorAttribute(color) | FOREGROUND_INTENSITY);
+    vprintf(fmt, args);
+
+    fflush(stdout);
+    // Restores the text color.
+    SetConsoleTextAttribute(stdout_handle, old_color_attrs);
+#else
+    printf("\033[0;3%sm", GetAnsiColorCode(color));
+    vprintf(fmt, args);
+    printf("\033[m");  // Resets the terminal to default.
+#endif  // H2OFT_OS_WINDOWS && !H2OFT_OS_WINDOWS_MOBILE
+    va_end(args);
+}
+
+namespace H2OFastTests {
+    namespace detail {
+
+        H2OFT_DECL Options& get_options() {
+            static Options options;
+            return options;
+        }
+
+        H2OFT_DECL uint64_t get_seed() {
+            // Drawn once even if the first calls race from the worker threads
+            static std::mutex mutex;
+            std::lock_guard<std::mutex> lock{ mutex };
+            auto& options = get_options();
+            if (options.seed == 0) {
+                std::random_device device;
+                options.seed = (static_cast<uint64_t>(device()) << 32) ^ device() ^ 1;
+            }
+            return options.seed;
+        }
+
+        H2OFT_DECL uint64_t iteration_seed(uint64_t seed, const std::string& label, size_t iteration) {
+            // FNV-1a of the label : std::hash differs between standard libraries, the seeds must replay everywhere
+            uint64_t label_hash = 0xCBF29CE484222325ull;
+            for (const auto c : label) {
+                label_hash = (label_hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+            }
+            auto x = seed ^ (label_hash + 0x9E3779B97F4A7C15ull * (iteration + 1));
+            // splitmix64 finalizer
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        H2OFT_DECL ResourceUsage resource_usage_snapshot() {
+            ResourceUsage usage;
+#if H2OFT_OS_LINUX
+            rusage thread_usage;
+            if (getrusage(RUSAGE_THREAD, &thread_usage) != 0)
+                return usage;
+            const auto to_duration = [](const timeval& time) {
+                return Duration{ static_cast<double>(time.tv_sec) * 1e3 + static_cast<double>(time.tv_usec) / 1e3 };
+            };
+            usage.collected = true;
+            usage.user_time = to_duration(thread_usage.ru_utime);
+            usage.system_time = to_duration(thread_usage.ru_stime);
+            usage.minor_faults = thread_usage.ru_minflt;
+            usage.major_faults = thread_usage.ru_majflt;
+            usage.voluntary_switches = thread_usage.ru_nvcsw;
+            usage.involuntary_switches = thread_usage.ru_nivcsw;
+            usage.max_rss_bytes = thread_usage.ru_maxrss * 1024;
+            // statm : size resident shared text lib data dt, in pages
+            std::ifstream statm("/proc/self/statm");
+            long size = 0, resident = 0;
+            if (statm >> size >> resident) {
+                usage.rss_bytes = resident * sysconf(_SC_PAGESIZE);
+            }
+#endif
+            return usage;
+        }
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, Test::Status status) {
+            switch (status) {
+            case Test::Status::PASSED:
+                os << "PASSED";
+                break;
+            case Test::Status::FAILED:
+                os << "FAILED";
+                break;
+            case Test::Status::ERROR:
+                os << "ERROR";
+                break;
+            case Test::Status::SKIPPED:
+                os << "SKIPPED";
+                break;
+            case Test::Status::CANCELLED:
+                os << "CANCELLED";
+                break;
+            case Test::Status::NONE:
+            default:
+                os << "NOT RUN YET";
+                break;
+            }
+            return os;
+        }
+
+        H2OFT_DECL std::string to_string(Test::Status status) {
+            std::ostringstream os;
+            os << status;
+            return os.str();
+        }
+
+        H2OFT_DECL uint32_t StringPool::intern(std::string_view value) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            const auto found = ids_.find(value);
+            if (found != ids_.end())
+                return found->second;
+            const auto id = static_cast<uint32_t>(strings_.size());
+            strings_.emplace_back(value);
+            ids_.emplace(strings_.back(), id);
+            return id;
+        }
+
+        H2OFT_DECL const std::string& StringPool::get(uint32_t id) const {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            return strings_[id];
+        }
+
+        H2OFT_DECL size_t StringPool::size() const {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            return strings_.size();
+        }
+
+        H2OFT_DECL StringPool& get_string_pool() {
+            static StringPool pool;
+            return pool;
+        }
+
+        H2OFT_DECL void ResultTable::add(const Test& test, uint32_t scenario_id) {
+            const auto status = test.getStatus();
+            auto& pool = get_string_pool();
+            const auto& message = status == Test::Status::FAILED ? test.getFailureReason() : status == Test::Status::ERROR ? test.getError() :
+                status == Test::Status::SKIPPED || status == Test::Status::CANCELLED ? test.getSkippedReason() : std::string{};
+            statuses_.push_back(static_cast<uint8_t>(status));
+            durations_ms_.push_back(test.getExecTimeMs().count());
+            scenario_ids_.push_back(scenario_id);
+            label_ids_.push_back(pool.intern(test.getLabel(false)));
+            message_ids_.push_back(message.empty() ? 0 : pool.intern(message));
+            tests_.push_back(&test);
+            ++counts_[static_cast<size_t>(status)];
+        }
+
+        H2OFT_DECL Duration ResultTable::getTotalDuration() const {
+            double total = 0.;
+            for (const auto duration : durations_ms_) {
+                total += duration;
+            }
+            return Duration{ total };
+        }
+
+        H2OFT_DECL std::vector<uint32_t> ResultTable::select(Test::Status status) const {
+            std::vector<uint32_t> rows;
+            rows.reserve(count(status));
+            const auto value = static_cast<uint8_t>(status);
+            for (size_t row = 0; row < statuses_.size(); ++row) {
+                if (statuses_[row] == value) {
+                    rows.push_back(static_cast<uint32_t>(row));
+                }
+            }
+            return rows;
+        }
+
+        H2OFT_DECL std::vector<uint32_t> ResultTable::sortByDuration(size_t count) const {
+            std::vector<uint32_t> rows(size());
+            for (size_t row = 0; row < rows.size(); ++row) {
+                rows[row] = static_cast<uint32_t>(row);
+            }
+            const auto slower = [this](uint32_t lhs, uint32_t rhs) { return durations_ms_[lhs] > durations_ms_[rhs]; };
+            if (count > 0 && count < rows.size()) {
+                std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(count), rows.end(), slower);
+                rows.resize(count);
+            }
+            else {
+                std::stable_sort(rows.begin(), rows.end(), slower);
+            }
+            return rows;
+        }
+
+        struct UnownedFailures {
+            std::mutex mutex;
+            std::vector<std::string> failures;
+        };
+
+        H2OFT_DECL UnownedFailures& unowned_failures() {
+            static UnownedFailures failures;
+            return failures;
+        }
+
+        H2OFT_DECL bool report_unowned_failure(const std::string& message) {
+            const auto running = running_tests_count().load();
+            if (running == 0)
+                return false;
+            const auto test = running == 1 ? running_test().load() : nullptr;
+            if (test != nullptr) {
+                test->getFailureSink().addFailure(message);
+                return true;
+            }
+            auto& unowned = unowned_failures();
+            {
+                std::lock_guard<std::mutex> lock{ unowned.mutex };
+                unowned.failures.push_back(message);
+            }
+            std::cerr << "UNOWNED FAILURE (" << running << " tests running): " << message << std::endl;
+            get_cancellation_token().addFailure(get_options().fail_fast);
+            return true;
+        }
+
+        // Number of unowned failures raised since the start of the program
+        H2OFT_DECL size_t unowned_failure_count() {
+            auto& unowned = unowned_failures();
+            std::lock_guard<std::mutex> lock{ unowned.mutex };
+            return unowned.failures.size();
+        }
+
+        H2OFT_DECL std::vector<std::string> get_unowned_failures() {
+            auto& unowned = unowned_failures();
+            std::lock_guard<std::mutex> lock{ unowned.mutex };
+            return unowned.failures;
+        }
+
+        // Read-only view of a file : mapped on Linux, read in memory elsewhere
+        class MappedFile {
+        public:
+
+            explicit MappedFile(const std::string& path) {
+#if H2OFT_OS_LINUX
+                const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                    return;
+                struct stat info;
+                if (::fstat(fd, &info) == 0) {
+                    size_ = static_cast<size_t>(info.st_size);
+                    void* mapping = size_ == 0 ? nullptr : ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapping != MAP_FAILED) {
+                        if (mapping != nullptr) {
+                            ::madvise(mapping, size_, MADV_SEQUENTIAL);
+                        }
+                        data_ = static_cast<const char*>(mapping);
+                        valid_ = true;
+                    }
+                }
+                ::close(fd);
+#else
+                std::ifstream file(path, std::ios::binary);
+                if (!file)
+                    return;
+                buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                data_ = buffer_.data();
+                size_ = buffer_.size();
+                valid_ = true;
+#endif
+            }
+
+            ~MappedFile() {
+#if H2OFT_OS_LINUX
+                if (data_ != nullptr) {
+                    ::munmap(const_cast<char*>(data_), size_);
+                }
+#endif
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            bool isValid() const { return valid_; }
+            const char* getData() const { return data_; }
+            size_t getSize() const { return size_; }
+
+        private:
+
+            bool valid_ = false;
+            const char* data_ = nullptr;
+            size_t size_ = 0;
+#if !H2OFT_OS_LINUX
+            std::vector<char> buffer_;
+#endif
+        };
+
+        // Offset of the first different byte, size if none : memcmp (vectorized) skips the equal chunks
+        H2OFT_DECL size_t first_difference(const char* lhs, const char* rhs, size_t size) {
+            constexpr size_t chunk_size = 64 * 1024;
+            for (size_t offset = 0; offset < size; offset += chunk_size) {
+                const auto length = std::min(chunk_size, size - offset);
+                if (std::memcmp(lhs + offset, rhs + offset, length) != 0) {
+                    return static_cast<size_t>(std::mismatch(lhs + offset, lhs + offset + length, rhs + offset).first - lhs);
+                }
+            }
+            return size;
+        }
+
+        // Non-cryptographic hash of a buffer : 4 lanes of 64 bits words, finalized as splitmix64
+        H2OFT_DECL uint64_t content_hash(const char* data, size_t size) {
+            uint64_t lanes[4] = { 0x9E3779B97F4A7C15ull, 0xBF58476D1CE4E5B9ull, 0x94D049BB133111EBull, size };
+            size_t offset = 0;
+            for (; offset + sizeof(lanes) <= size; offset += sizeof(lanes)) {
+                for (size_t lane = 0; lane < 4; ++lane) {
+                    uint64_t word;
+                    std::memcpy(&word, data + offset + lane * sizeof(word), sizeof(word));
+                    lanes[lane] = (lanes[lane] ^ word) * 0xFF51AFD7ED558CCDull;
+                    lanes[lane] ^= lanes[lane] >> 32;
+                }
+            }
+            auto x = lanes[0] ^ (lanes[1] * 3) ^ (lanes[2] * 5) ^ (lanes[3] * 7);
+            for (; offset < size; ++offset) {
+                x = (x ^ static_cast<unsigned char>(data[offset])) * 0x100000001B3ull;
+            }
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        // Hex/text dump of the lines of 16 bytes around offset, the byte at offset is followed by a '<'
+        H2OFT_DECL std::string hex_window(const char* data, size_t size, size_t offset) {
+            constexpr size_t line_size = 16;
+            const auto line = std::min(offset, size) / line_size * line_size;
+            const auto begin = line >= line_size ? line - line_size : 0;
+            const auto end = std::min(size, line + 2 * line_size);
+            std::ostringstream oss;
+            oss << size << " bytes" << std::hex << std::setfill('0');
+            for (auto address = begin; address < end; address += line_size) {
+                oss << "\n\t\t\t\t" << std::setw(8) << address << ": ";
+                for (auto index = address; index < address + line_size; ++index) {
+                    if (index < end) {
+                        oss << std::setw(2) << static_cast<unsigned>(static_cast<unsigned char>(data[index])) << (index == offset ? '<' : ' ');
+                    }
+                    else {
+                        oss << "   ";
+                    }
+                }
+                oss << '|';
+                for (auto index = address; index < std::min(end, address + line_size); ++index) {
+                    oss << (std::isprint(static_cast<unsigned char>(data[index])) ? data[index] : '.');
+                }
+                oss << '|';
+            }
+            return oss.str();
+        }
+
+        // First line of the hash file of a snapshot : the snapshot is identified by its size and write time
+        H2OFT_DECL std::string snapshot_stamp(const std::string& path, uint64_t hash) {
+            std::error_code error;
+            const auto size = std::filesystem::file_size(path, error);
+            if (error)
+                return{};
+            const auto time = std::filesystem::last_write_time(path, error);
+            if (error)
+                return{};
+            std::ostringstream oss;
+            oss << size << ' ' << time.time_since_epoch().count() << ' ' << std::hex << hash;
+            return oss.str();
+        }
+
+        // Write a temporary file renamed over path : readers see the old or the new content, never a partial one
+        H2OFT_DECL bool write_file_atomically(const char* data, size_t size, const std::string& path) {
+            static std::atomic<uint64_t> counter{ 0 };
+            std::ostringstream temporary;
+            temporary << path << ".tmp." << std::hex
+                << (iteration_seed(get_seed(), path, static_cast<size_t>(counter++)) ^ std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#if H2OFT_OS_LINUX
+            const auto fd = ::open(temporary.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+                return false;
+            size_t written = 0;
+            while (written < size) {
+                const auto count = ::write(fd, data + written, size - written);
+                if (count < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+                written += static_cast<size_t>(count);
+            }
+            auto success = written == size && ::fsync(fd) == 0;
+            success = ::close(fd) == 0 && success;
+#else
+            std::ofstream file(temporary.str(), std::ios::binary | std::ios::trunc);
+            file.write(data, static_cast<std::streamsize>(size));
+            file.close();
+            const auto success = !file.fail();
+#endif
+            std::error_code error;
+            if (success) {
+                std::filesystem::rename(temporary.str(), path, error);
+            }
+            if (!success || error) {
+                std::filesystem::remove(temporary.str(), error);
+                return false;
+            }
+            return true;
+        }
+
+        H2OFT_DECL SnapshotComparison compare_snapshot(const char* data, size_t size, const std::string& path) {
+            SnapshotComparison comparison;
+            // Fast path : the hash saved with the snapshot, as long as the file wasn't changed since
+            std::ifstream hash_file(path + ".hash");
+            std::string saved_stamp;
+            size_t saved_size = 0;
+            if (std::getline(hash_file, saved_stamp) && (std::istringstream{ saved_stamp } >> saved_size) && saved_size == size
+                && saved_stamp == snapshot_stamp(path, content_hash(data, size))) {
+                comparison.matches = true;
+                return comparison;
+            }
+            const MappedFile snapshot{ path };
+            if (!snapshot.isValid()) {
+                comparison.summary = "[SNAPSHOT] '" + path + "' can't be read, set Options::update_snapshots to write it";
+                return comparison;
+            }
+            const auto offset = first_difference(data, snapshot.getData(), std::min(size, snapshot.getSize()));
+            if (offset == size && size == snapshot.getSize()) {
+                comparison.matches = true;
+                return comparison;
+            }
+            std::ostringstream oss;
+            oss << "[SNAPSHOT] '" << path << "' differs at byte offset " << offset << " (0x" << std::hex << offset << std::dec
+                << ", reached " << size << " bytes, expected " << snapshot.getSize() << " bytes)";
+            comparison.summary = oss.str();
+            comparison.reached = hex_window(data, size, offset);
+            comparison.expected = hex_window(snapshot.getData(), snapshot.getSize(), offset);
+            return comparison;
+        }
+
+        H2OFT_DECL bool write_snapshot(const char* data, size_t size, const std::string& path) {
+            std::error_code error;
+            const auto directory = std::filesystem::path{ path }.parent_path();
+            if (!directory.empty()) {
+                std::filesystem::create_directories(directory, error);
+            }
+            if (!write_file_atomically(data, size, path))
+                return false;
+            const auto stamp = snapshot_stamp(path, content_hash(data, size)) + '\n';
+            return write_file_atomically(stamp.data(), stamp.size(), path + ".hash");
+        }
+
+        H2OFT_DECL SnapshotComparison match_snapshot(const char* data, size_t size, const std::string& path) {
+            if (!get_options().update_snapshots)
+                return compare_snapshot(data, size, path);
+            SnapshotComparison comparison;
+            comparison.matches = write_snapshot(data, size, path);
+            if (!comparison.matches) {
+                comparison.summary = "[SNAPSHOT] '" + path + "' can't be written";
+            }
+            return comparison;
+        }
+
+        H2OFT_DECL VirtualClock::Nanoseconds VirtualClock::now() const {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            return now_;
+        }
+
+        H2OFT_DECL void VirtualClock::advance(Nanoseconds duration) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            now_ += std::max(duration, Nanoseconds{ 0 });
+            release();
+        }
+
+        H2OFT_DECL void VirtualClock::sleep_until(Nanoseconds deadline) {
+            Waiter waiter;
+            if (!enter(deadline, waiter))
+                return;
+            std::unique_lock<std::mutex> lock{ mutex_ };
+            while (!waiter.released.load(std::memory_order_relaxed)) {
+                advance_if_blocked();
+                released_.wait_for(lock, poll_period);
+            }
+        }
+
+        H2OFT_DECL void VirtualClock::attach() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            ++threads_;
+            ++epoch_;
+        }
+
+        H2OFT_DECL void VirtualClock::detach() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            --threads_;
+            ++epoch_;
+        }
+
+        H2OFT_DECL void VirtualClock::park() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            ++blocked_;
+            ++epoch_;
+        }
+
+        H2OFT_DECL void VirtualClock::unpark() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            --blocked_;
+            ++epoch_;
+        }
+
+        H2OFT_DECL bool VirtualClock::enter(Nanoseconds deadline, Waiter& waiter) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            if (deadline <= now_)
+                return false;
+            waiter.entry = waiters_.emplace(deadline, &waiter);
+            ++blocked_;
+            ++epoch_;
+            return true;
+        }
+
+        H2OFT_DECL void VirtualClock::leave(Waiter& waiter) {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            if (!waiter.released.load(std::memory_order_relaxed)) {
+                waiters_.erase(waiter.entry);
+                --blocked_;
+                ++epoch_;
+            }
+        }
+
+        H2OFT_DECL void VirtualClock::poll() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            advance_if_blocked();
+        }
+
+        H2OFT_DECL void VirtualClock::advance_if_blocked() {
+            if (!auto_advance_ || blocked_ < threads_ || waiters_.empty())
+                return;
+            const auto real_now = std::chrono::steady_clock::now();
+            if (quiet_epoch_ != epoch_) {
+                quiet_epoch_ = epoch_;
+                quiet_since_ = real_now;
+            }
+            else if (real_now - quiet_since_ >= grace_period) {
+                now_ = std::max(now_, waiters_.begin()->first);
+                release();
+            }
+        }
+
+        H2OFT_DECL void VirtualClock::release() {
+            // Released waiters stop counting as blocked right away, before they run again
+            while (!waiters_.empty() && waiters_.begin()->first <= now_) {
+                waiters_.begin()->second->released.store(true, std::memory_order_release);
+                waiters_.erase(waiters_.begin());
+                --blocked_;
+            }
+            ++epoch_;
+            released_.notify_all();
+        }
+
+        H2OFT_DECL TestClock::time_point TestClock::now() {
+            if (const auto clock = virtual_clock())
+                return time_point{ clock->now() };
+            return time_point{ std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()) };
+        }
+
+        H2OFT_DECL void TestClock::sleep_until(time_point deadline) {
+            if (const auto clock = virtual_clock()) {
+                clock->sleep_until(deadline.time_since_epoch());
+                return;
+            }
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point{ std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline.time_since_epoch()) });
+        }
+
+        H2OFT_DECL void TestClock::advance(duration elapsed) {
+            const auto clock = virtual_clock();
+            if (clock == nullptr)
+                throw std::logic_error{ "TestClock::advance() called outside of a test using a virtual clock" };
+            clock->advance(elapsed);
+        }
+
+        H2OFT_DECL Histogram& test_histogram(const std::string& name) {
+            if (current_test() == nullptr)
+                throw std::logic_error{ "test_histogram() called outside of a running test" };
+            return current_test()->getHistogram(name);
+        }
+
+        H2OFT_DECL uint64_t test_seed() {
+            if (current_test() == nullptr)
+                throw std::logic_error{ "test_seed() called outside of a running test" };
+            return current_test()->getSeed();
+        }
+
+        H2OFT_DECL std::unique_ptr<Test> make_test(TestFunctor&& func) { return std::make_unique<Test>(std::move(func)); }
+
+        H2OFT_DECL std::unique_ptr<Test> make_test(const std::string& label, TestFunctor&& func) { return std::make_unique<Test>(label, std::move(func)); }
+
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(TestFunctor&& test) { return std::make_unique<SkippedTest>(std::move(test)); }
+
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(const std::string& label, TestFunctor&& func) { return std::make_unique<SkippedTest>(label, std::move(func)); }
+
+        H2OFT_DECL std::unique_ptr<Test> make_skipped_test(const std::string& reason, const std::string& label, TestFunctor&& func) { return std::make_unique<SkippedTest>(reason, label, std::move(func)); }
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, BenchmarkVerdict verdict) {
+            switch (verdict) {
+            case BenchmarkVerdict::IMPROVED:
+                os << "IMPROVED";
+                break;
+            case BenchmarkVerdict::REGRESSED:
+                os << "REGRESSED";
+                break;
+            case BenchmarkVerdict::UNCHANGED:
+                os << "UNCHANGED";
+                break;
+            case BenchmarkVerdict::NONE:
+            default:
+                os << "NO BASELINE";
+                break;
+            }
+            return os;
+        }
+
+        H2OFT_DECL double normal_upper_quantile(double p) {
+            const auto t = std::sqrt(-2. * std::log(p));
+            return t - (2.515517 + 0.802853 * t + 0.010328 * t * t) /
+                (1. + 1.432788 * t + 0.189269 * t * t + 0.001308 * t * t * t);
+        }
+
+        H2OFT_DECL double median(std::vector<double> values) {
+            if (values.empty())
+                return 0.;
+            const auto middle = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + middle, values.end());
+            auto result = values[middle];
+            if (values.size() % 2 == 0) {
+                result = (result + *std::max_element(values.begin(), values.begin() + middle)) / 2.;
+            }
+            return result;
+        }
+
+        H2OFT_DECL double coefficient_of_variation(const std::vector<double>& values) {
+            if (values.size() < 2)
+                return 0.;
+            double mean = 0.;
+            for (const auto value : values) {
+                mean += value;
+            }
+            mean /= static_cast<double>(values.size());
+            if (mean <= 0.)
+                return 0.;
+            double variance = 0.;
+            for (const auto value : values) {
+                variance += (value - mean) * (value - mean);
+            }
+            return std::sqrt(variance / static_cast<double>(values.size() - 1)) / mean;
+        }
+
+        H2OFT_DECL BenchmarkComparison compare_samples(const std::vector<double>& baseline, const std::vector<double>& current, double significance) {
+            BenchmarkComparison comparison;
+            const auto n1 = baseline.size();
+            const auto n2 = current.size();
+            if (n1 < 3 || n2 < 3)
+                return comparison;
+
+            // Rank the pooled samples, ties get their average rank
+            std::vector<std::pair<double, bool>> pooled;
+            pooled.reserve(n1 + n2);
+            for (auto value : baseline) pooled.emplace_back(value, false);
+            for (auto value : current) pooled.emplace_back(value, true);
+            std::sort(pooled.begin(), pooled.end(), [](const std::pair<double, bool>& lhs, const std::pair<double, bool>& rhs) {
+                return lhs.first < rhs.first;
+            });
+            double rank_sum_current = 0.;
+            double ties_correction = 0.;
+            for (size_t i = 0; i < pooled.size();) {
+                auto j = i;
+                while (j < pooled.size() && pooled[j].first == pooled[i].first) ++j;
+                const auto rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.;
+                for (auto k = i; k < j; ++k) {
+                    if (pooled[k].second) rank_sum_current += rank;
+                }
+                const auto ties = static_cast<double>(j - i);
+                ties_correction += ties * ties * ties - ties;
+                i = j;
+            }
+
+            const auto dn1 = static_cast<double>(n1);
+            const auto dn2 = static_cast<double>(n2);
+            const auto n = dn1 + dn2;
+            const auto u = rank_sum_current - dn2 * (dn2 + 1.) / 2.;
+            const auto mean = dn1 * dn2 / 2.;
+            const auto sigma = std::sqrt(dn1 * dn2 / 12. * ((n + 1.) - ties_correction / (n * (n - 1.))));
+            if (sigma > 0.) {
+                const auto z = (std::abs(u - mean) - 0.5) / sigma;
+                comparison.p_value = std::min(1., std::erfc(std::max(0., z) / std::sqrt(2.)));
+            }
+
+            // Hodges-Lehmann estimator of the shift with its confidence interval
+            std::vector<double> differences;
+            differences.reserve(n1 * n2);
+            for (auto c : current) {
+                for (auto b : baseline) {
+                    differences.push_back(c - b);
+                }
+            }
+            std::sort(differences.begin(), differences.end());
+            const auto reference = median(baseline);
+            const auto z_crit = normal_upper_quantile(significance / 2.);
+            const auto count = static_cast<double>(differences.size());
+            auto c_alpha = static_cast<size_t>(std::max(1., std::floor(mean - z_crit * std::sqrt(dn1 * dn2 * (n + 1.) / 12.))));
+            c_alpha = std::min(c_alpha, differences.size());
+            if (reference > 0.) {
+                comparison.shift = median(differences) / reference;
+                comparison.shift_low = differences[c_alpha - 1] / reference;
+                comparison.shift_high = differences[static_cast<size_t>(count) - c_alpha] / reference;
+            }
+
+            if (comparison.p_value < significance) {
+                comparison.verdict = comparison.shift > 0. ? BenchmarkVerdict::REGRESSED : BenchmarkVerdict::IMPROVED;
+            }
+            else {
+                comparison.verdict = BenchmarkVerdict::UNCHANGED;
+            }
+            return comparison;
+        }
+
+        H2OFT_DECL BenchmarkStorage& get_benchmark_storage() {
+            static BenchmarkStorage storage;
+            return storage;
+        }
+
+        H2OFT_DECL const std::vector<std::string>& BenchmarkStorage::getEnvironmentWarnings() {
+            std::call_once(environment_checked_, [this]() {
+                environment_warnings_ = check_benchmark_environment(cpu_affinity_, raise_priority_);
+            });
+            return environment_warnings_;
+        }
+
+#if H2OFT_OS_LINUX
+        // First line of a (sysfs) file, empty if it can't be read
+        H2OFT_DECL std::string read_first_line(const std::string& path) {
+            std::ifstream file(path);
+            std::string line;
+            std::getline(file, line);
+            return line;
+        }
+
+        // Cpus of a sysfs list such as "0-3,8"
+        H2OFT_DECL std::vector<int> parse_cpu_list(const std::string& list) {
+            std::vector<int> cpus;
+            std::istringstream iss(list);
+            std::string range;
+            while (std::getline(iss, range, ',')) {
+                const auto dash = range.find('-');
+                try {
+                    const auto first = std::stoi(range.substr(0, dash));
+                    const auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                    for (auto cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                }
+                catch (const std::exception&) {}
+            }
+            return cpus;
+        }
+
+        // Busy and total jiffies of each cpu (/proc/stat)
+        H2OFT_DECL std::map<int, std::pair<uint64_t, uint64_t>> cpu_times() {
+            std::map<int, std::pair<uint64_t, uint64_t>> times;
+            std::ifstream file("/proc/stat");
+            std::string line;
+            while (std::getline(file, line)) {
+                if (line.compare(0, 3, "cpu") != 0 || line.size() < 4 || !std::isdigit(static_cast<unsigned char>(line[3])))
+                    continue;
+                std::istringstream iss(line.substr(3));
+                int cpu = 0;
+                iss >> cpu;
+                uint64_t value = 0;
+                uint64_t total = 0;
+                uint64_t idle = 0;
+                for (size_t field = 0; iss >> value; ++field) {
+                    total += value;
+                    if (field == 3 || field == 4) { // idle and iowait
+                        idle += value;
+                    }
+                }
+                times[cpu] = { total - idle, total };
+            }
+            return times;
+        }
+#endif
+
+        H2OFT_DECL std::vector<std::string> check_benchmark_environment(const std::vector<int>& cpus, bool raise_priority) {
+            std::vector<std::string> warnings;
+#if H2OFT_OS_LINUX
+            const auto online = parse_cpu_list(read_first_line("/sys/devices/system/cpu/online"));
+            const auto& checked = cpus.empty() ? online : cpus;
+            const std::string cpu_root = "/sys/devices/system/cpu/cpu";
+
+            std::map<std::string, std::string> governors;
+            for (const auto cpu : checked) {
+                const auto governor = read_first_line(cpu_root + std::to_string(cpu) + "/cpufreq/scaling_governor");
+                if (!governor.empty() && governor != "performance") {
+                    auto& list = governors[governor];
+                    list += (list.empty() ? "" : ",") + std::to_string(cpu);
+                }
+            }
+            for (const auto& governor : governors) {
+                warnings.push_back("scaling governor '" + governor.first + "' on cpu " + governor.second);
+            }
+
+            if (read_first_line("/sys/devices/system/cpu/intel_pstate/no_turbo") == "0" || read_first_line("/sys/devices/system/cpu/cpufreq/boost") == "1") {
+                warnings.push_back("turbo boost enabled");
+            }
+
+            double load = 0.;
+            const auto count = std::max<size_t>(online.size(), 1);
+            // The benchmark itself accounts for one running task
+            if (::getloadavg(&load, 1) == 1 && load - 1. > static_cast<double>(count) / 2.) {
+                std::ostringstream oss;
+                oss << "load average " << load << " on " << count << " cpus";
+                warnings.push_back(oss.str());
+            }
+
+            if (!cpus.empty()) {
+                std::set<int> siblings;
+                for (const auto cpu : cpus) {
+                    for (const auto sibling : parse_cpu_list(read_first_line(cpu_root + std::to_string(cpu) + "/topology/thread_siblings_list"))) {
+                        if (std::find(cpus.begin(), cpus.end(), sibling) == cpus.end()) {
+                            siblings.insert(sibling);
+                        }
+                    }
+                }
+                if (!siblings.empty()) {
+                    const auto before = cpu_times();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    const auto after = cpu_times();
+                    for (const auto sibling : siblings) {
+                        const auto first = before.find(sibling);
+                        const auto last = after.find(sibling);
+                        if (first == before.end() || last == after.end() || last->second.second <= first->second.second)
+                            continue;
+                        const auto busy = static_cast<double>(last->second.first - first->second.first) / static_cast<double>(last->second.second - first->second.second);
+                        if (busy > 0.1) {
+                            warnings.push_back("SMT sibling cpu " + std::to_string(sibling) + " busy " + std::to_string(static_cast<int>(busy * 100.)) + "%");
+                        }
+                    }
+                }
+
+                cpu_set_t allowed;
+                if (::sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+                    for (const auto cpu : cpus) {
+                        if (cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+                            warnings.push_back("cpu " + std::to_string(cpu) + " can't be used for pinning");
+                        }
+                    }
+                }
+            }
+
+            if (raise_priority) {
+                errno = 0;
+                const auto priority = ::getpriority(PRIO_PROCESS, 0);
+                if (::setpriority(PRIO_PROCESS, 0, -10) != 0) {
+                    warnings.push_back("priority can't be raised (needs CAP_SYS_NICE or RLIMIT_NICE)");
+                }
+                else {
+                    ::setpriority(PRIO_PROCESS, 0, errno == 0 ? priority : 0);
+                }
+            }
+#else
+            if (!cpus.empty() || raise_priority) {
+                warnings.push_back("cpu pinning and priority are only supported on Linux");
+            }
+#endif
+            return warnings;
+        }
+
+        H2OFT_DECL BenchmarkEnvironment::BenchmarkEnvironment() {
+            auto& storage = get_benchmark_storage();
+            storage.getEnvironmentWarnings();
+#if H2OFT_OS_LINUX
+            const auto& cpus = storage.getCpuAffinity();
+            if (!cpus.empty() && ::sched_getaffinity(0, sizeof(previous_affinity_), &previous_affinity_) == 0) {
+                cpu_set_t affinity;
+                CPU_ZERO(&affinity);
+                for (const auto cpu : cpus) {
+                    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                        CPU_SET(cpu, &affinity);
+                    }
+                }
+                pinned_ = ::sched_setaffinity(0, sizeof(affinity), &affinity) == 0;
+            }
+            if (storage.getRaisePriority()) {
+                errno = 0;
+                previous_priority_ = ::getpriority(PRIO_PROCESS, 0);
+                prioritized_ = errno == 0 && ::setpriority(PRIO_PROCESS, 0, -10) == 0;
+            }
+#endif
+        }
+
+        H2OFT_DECL BenchmarkEnvironment::~BenchmarkEnvironment() {
+#if H2OFT_OS_LINUX
+            if (pinned_) {
+                ::sched_setaffinity(0, sizeof(previous_affinity_), &previous_affinity_);
+            }
+            if (prioritized_) {
+                ::setpriority(PRIO_PROCESS, 0, previous_priority_);
+            }
+#endif
+        }
+
+        H2OFT_DECL Duration evict_caches(std::vector<char>& buffer) {
+            constexpr size_t cache_line = 64;
+            const auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < buffer.size(); i += cache_line) {
+                ++buffer[i];
+            }
+            char sum = 0;
+            for (size_t i = 0; i < buffer.size(); i += cache_line) {
+                sum += buffer[i];
+            }
+            DoNotOptimize(sum);
+            ClobberMemory();
+            return std::chrono::high_resolution_clock::now() - start;
+        }
+
+        H2OFT_DECL std::unique_ptr<Test> make_benchmark(const std::string& label, TestFunctor&& func, size_t samples, size_t iterations) { return std::make_unique<Benchmark>(label, std::move(func), samples, iterations); }
+
+        H2OFT_DECL std::unique_ptr<Test> make_benchmark(const std::string& label, BenchmarkFunctor&& func, size_t samples, size_t iterations) { return std::make_unique<Benchmark>(label, std::move(func), samples, iterations); }
+
+        H2OFT_DECL std::ostream& operator<<(std::ostream& os, Complexity complexity) {
+            switch (complexity) {
+            case O_1:
+                os << "O(1)";
+                break;
+            case O_LogN:
+                os << "O(log n)";
+                break;
+            case O_N:
+                os << "O(n)";
+                break;
+            case O_NLogN:
+                os << "O(n log n)";
+                break;
+            case O_N2:
+            default:
+                os << "O(n^2)";
+                break;
+            }
+            return os;
+        }
+
+        H2OFT_DECL double complexity_function(Complexity complexity, double n) {
+            switch (complexity) {
+            case O_1: return 1.;
+            case O_LogN: return std::log2(n);
+            case O_N: return n;
+            case O_NLogN: return n * std::log2(n);
+            case O_N2:
+            default: return n * n;
+            }
+        }
+
+        H2OFT_DECL ComplexityFit fit_complexity(const std::vector<std::pair<double, double>>& points, Complexity complexity) {
+            ComplexityFit fit;
+            fit.complexity = complexity;
+            if (points.empty())
+                return fit;
+            double sum_tf = 0., sum_ff = 0., sum_t = 0.;
+            for (const auto& point : points) {
+                const auto f = complexity_function(complexity, point.first);
+                sum_tf += point.second * f;
+                sum_ff += f * f;
+                sum_t += point.second;
+            }
+            fit.coefficient = sum_ff > 0. ? sum_tf / sum_ff : 0.;
+            double residuals = 0.;
+            for (const auto& point : points) {
+                const auto residual = point.second - fit.coefficient * complexity_function(complexity, point.first);
+                residuals += residual * residual;
+            }
+            const auto count = static_cast<double>(points.size());
+            const auto mean = sum_t / count;
+            fit.rms = mean > 0. ? std::sqrt(residuals / count) / mean : 0.;
+            return fit;
+        }
+
+        H2OFT_DECL ComplexityFit best_fit_complexity(const std::vector<std::pair<double, double>>& points) {
+            auto best = fit_complexity(points, O_1);
+            for (auto complexity : { O_LogN, O_N, O_NLogN, O_N2 }) {
+                const auto fit = fit_complexity(points, complexity);
+                if (fit.rms < best.rms) {
+                    best = fit;
+                }
+            }
+            return best;
+        }
+
+        H2OFT_DECL RegistryStorage& get_registry() {
+            static RegistryStorage registry;
+            return registry;
+        }
+
+        H2OFT_DECL CancellationToken& get_cancellation_token() {
+            static CancellationToken token;
+            return token;
+        }
+
+        H2OFT_DECL std::atomic<ProgressFile*>& get_progress() {
+            static std::atomic<ProgressFile*> progress{ nullptr };
+            return progress;
+        }
+
+        H2OFT_DECL uint64_t progress_time_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        // The progress file is shared with other processes : only with address-free (lock-free) atomics
+        H2OFT_DECL bool progress_supported() {
+            return std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free;
+        }
+
+        H2OFT_DECL void open_progress(const std::string& path) {
+            static std::mutex mutex;
+            static std::string opened;
+            std::lock_guard<std::mutex> lock{ mutex };
+            if (path == opened)
+                return;
+            opened = path;
+            ProgressFile* progress = nullptr;
+            if (!path.empty() && !progress_supported()) {
+                ColoredPrintf(COLOR_YELLOW, "WARNING: progress file %s disabled, 64 bits atomics aren't lock-free on this target\n", path.c_str());
+            }
+#if H2OFT_OS_LINUX
+            if (!path.empty() && progress_supported()) {
+                const auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd >= 0) {
+                    if (::ftruncate(fd, sizeof(ProgressFile)) == 0) {
+                        void* mapping = ::mmap(nullptr, sizeof(ProgressFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                        if (mapping != MAP_FAILED) {
+                            progress = new (mapping) ProgressFile{};
+                            std::memcpy(progress->magic, "H2OFTPRG", sizeof(progress->magic));
+                            progress->version = 1;
+                            progress->pid = static_cast<uint32_t>(::getpid());
+                            progress->start_time_ns = progress_time_ns();
+                        }
+                    }
+                    ::close(fd);
+                }
+            }
+#endif
+            // The previous file stays mapped : the tests still running may publish to it
+            get_progress().store(progress, std::memory_order_release);
+        }
+
+        // Write a string guarded by its sequence number (single writer), the readers retry while it's odd or if it changed
+        H2OFT_DECL void publish_string(std::atomic<uint64_t>& sequence, char* destination, size_t size, const std::string& value) {
+            sequence.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            const auto length = std::min(value.size(), size - 1);
+            std::memcpy(destination, value.data(), length);
+            destination[length] = '\0';
+            sequence.fetch_add(1, std::memory_order_release);
+        }
+
+        // A writer that died while publishing leaves the sequence odd for good : "<torn>" after a bounded number of retries
+        H2OFT_DECL std::string read_published_string(const std::atomic<uint64_t>& sequence, const char* source, size_t size) {
+            for (size_t attempt = 0; attempt < 1000; ++attempt) {
+                const auto before = sequence.load(std::memory_order_acquire);
+                std::string value{ source, static_cast<size_t>(std::find(source, source + size, '\0') - source) };
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((before & 1) == 0 && sequence.load(std::memory_order_relaxed) == before)
+                    return value;
+                std::this_thread::yield();
+            }
+            return "<torn>";
+        }
+
+        // Worker slot of the calling thread in the progress file, freed when the thread exits (nullptr if none is left)
+        struct ProgressWorkerSlot {
+            ProgressFile* progress = nullptr;
+            ProgressFile::Worker* worker = nullptr;
+
+            ~ProgressWorkerSlot() { release(); }
+
+            void release() {
+                if (worker != nullptr) {
+                    publish_string(worker->sequence, worker->label, sizeof(worker->label), {});
+                    worker->taken.store(0, std::memory_order_release);
+                }
+                worker = nullptr;
+            }
+        };
+
+        H2OFT_DECL ProgressFile::Worker* progress_worker(ProgressFile& progress) {
+            thread_local ProgressWorkerSlot slot;
+            if (slot.progress != &progress) {
+                slot.release();
+                slot.progress = &progress;
+                for (size_t index = 0; index < ProgressFile::max_workers && slot.worker == nullptr; ++index) {
+                    auto& worker = progress.workers[index];
+                    uint64_t free = 0;
+                    if (worker.taken.compare_exchange_strong(free, 1)) {
+                        slot.worker = &worker;
+                        auto count = progress.worker_count.load();
+                        while (count < index + 1 && !progress.worker_count.compare_exchange_weak(count, static_cast<uint32_t>(index + 1))) {}
+                    }
+                }
+            }
+            return slot.worker;
+        }
+
+        // Publish the test run by the calling thread, an empty label once it's done
+        H2OFT_DECL void publish_test(ProgressFile& progress, const std::string& label) {
+            if (const auto worker = progress_worker(progress)) {
+                publish_string(worker->sequence, worker->label, sizeof(worker->label), label);
+                if (!label.empty()) {
+                    worker->tests.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            progress.elapsed_ns.store(progress_time_ns() - progress.start_time_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        H2OFT_DECL std::string read_progress(const std::string& path) {
+#if H2OFT_OS_LINUX
+            if (!progress_supported())
+                return{};
+            const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return{};
+            struct stat info;
+            void* mapping = MAP_FAILED;
+            if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ProgressFile)) {
+                mapping = ::mmap(nullptr, sizeof(ProgressFile), PROT_READ, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            if (mapping == MAP_FAILED)
+                return{};
+            const auto& progress = *static_cast<const ProgressFile*>(mapping);
+            std::ostringstream oss;
+            if (std::memcmp(progress.magic, "H2OFTPRG", sizeof(progress.magic)) == 0 && progress.version == 1) {
+                oss << "PROGRESS [pid " << progress.pid << "] [" << static_cast<double>(progress.elapsed_ns.load()) / 1e6 << " ms] : "
+                    << progress.done.load() << "/" << progress.total.load() << " tests, "
+                    << progress.passed.load() << " passed, " << progress.failed.load() << " failed, " << progress.errors.load() << " errors, "
+                    << progress.skipped.load() << " skipped, " << progress.cancelled.load() << " cancelled\n";
+                for (size_t index = 0; index < std::min<size_t>(progress.scenario_count.load(), ProgressFile::max_scenarios); ++index) {
+                    const auto& scenario = progress.scenarios[index];
+                    oss << "\tSCENARIO [" << read_published_string(scenario.sequence, scenario.name, sizeof(scenario.name)) << "] "
+                        << scenario.done.load() << "/" << scenario.total.load() << ", " << scenario.failed.load() << " failed\n";
+                }
+                for (size_t index = 0; index < std::min<size_t>(progress.worker_count.load(), ProgressFile::max_workers); ++index) {
+                    const auto& worker = progress.workers[index];
+                    const auto label = read_published_string(worker.sequence, worker.label, sizeof(worker.label));
+                    if (!label.empty()) {
+                        oss << "\tRUNNING [" << label << "] (worker " << index << ", " << worker.tests.load() << " tests)\n";
+                    }
+                }
+            }
+            ::munmap(mapping, sizeof(ProgressFile));
+            return oss.str();
+#else
+            (void)path;
+            return{};
+#endif
+        }
+
+        H2OFT_DECL TraceStorage& get_trace_storage() {
+            static TraceStorage storage;
+            return storage;
+        }
+
+        H2OFT_DECL TraceStorage::Buffer& TraceStorage::getThreadBuffer() {
+            thread_local std::shared_ptr<Buffer> buffer;
+            thread_local uint64_t generation = 0;
+            if (generation != generation_.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock{ mutex_ };
+                buffer = std::make_shared<Buffer>();
+                buffer->track = tracks_++;
+                buffers_.push_back(buffer);
+                generation = generation_.load(std::memory_order_relaxed);
+            }
+            return *buffer;
+        }
+
+        H2OFT_DECL void TraceStorage::clear() {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            buffers_.clear();
+            tracks_ = 0;
+            ++generation_;
+        }
+
+        H2OFT_DECL void write_json_string(std::ostream& os, const std::string& value) {
+            os << '"';
+            for (const auto c : value) {
+                switch (c) {
+                case '"': os << "\\\""; break;
+                case '\\': os << "\\\\"; break;
+                case '\n': os << "\\n"; break;
+                case '\t': os << "\\t"; break;
+                case '\r': os << "\\r"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+                    }
+                    else {
+                        os << c;
+                    }
+                }
+            }
+            os << '"';
+        }
+
+        H2OFT_DECL bool TraceStorage::save(const std::string& path) const {
+#if H2OFT_OS_LINUX
+            const auto pid = static_cast<long>(::getpid());
+#else
+            const long pid = 1;
+#endif
+            std::ofstream file(path);
+            file << std::fixed << std::setprecision(3);
+            file << "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"H2OFastTests\"}}";
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            for (const auto& buffer : buffers_) {
+                std::lock_guard<std::mutex> buffer_lock{ buffer->mutex };
+                file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->track
+                    << ",\"args\":{\"name\":\"thread " << buffer->track << "\"}}";
+                for (const auto& event : buffer->events) {
+                    file << ",\n{\"name\":";
+                    write_json_string(file, event.name);
+                    file << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << static_cast<double>(event.begin_ns) / 1e3
+                        << ",\"dur\":" << static_cast<double>(event.end_ns - event.begin_ns) / 1e3
+                        << ",\"pid\":" << pid << ",\"tid\":" << buffer->track << ",\"args\":{" << event.args << "}}";
+                }
+            }
+            file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return static_cast<bool>(file);
+        }
+
+        H2OFT_DECL ImpactIndex& get_impact_index() {
+            static ImpactIndex index;
+            return index;
+        }
+
+        H2OFT_DECL std::mutex& get_impact_mutex() {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        H2OFT_DECL void ImpactIndex::open(const std::string& path) {
+            if (path == path_)
+                return;
+            path_ = path;
+            functions_.clear();
+            function_ids_.clear();
+            tests_.clear();
+            pending_tests_.clear();
+            rewrite_ = false;
+            std::ifstream file(path);
+            std::string line;
+            size_t test_lines = 0;
+            bool cut = false;
+            while (std::getline(file, line)) {
+                // A last line without its end of line was cut by a crashed run : ignored, and rewritten before appending
+                if (file.eof()) {
+                    cut = true;
+                    break;
+                }
+                if (line.size() < 2 || line[1] != ' ')
+                    continue;
+                if (line[0] == 'F') {
+                    const auto tab = line.find('\t', 2);
+                    Function function{ line.substr(2, tab == std::string::npos ? std::string::npos : tab - 2), tab == std::string::npos ? std::string{} : line.substr(tab + 1) };
+                    function_ids_.emplace(function, static_cast<uint32_t>(functions_.size()));
+                    functions_.push_back(std::move(function));
+                }
+                else if (line[0] == 'T') {
+                    const auto tab = line.rfind('\t');
+                    if (tab == std::string::npos || tab < 2)
+                        continue;
+                    auto& ids = tests_[line.substr(2, tab - 2)];
+                    ids.clear();
+                    ++test_lines;
+                    std::istringstream iss{ line.substr(tab + 1) };
+                    uint32_t id;
+                    while (iss >> id) {
+                        if (id < functions_.size()) {
+                            ids.push_back(id);
+                        }
+                    }
+                }
+            }
+            written_functions_ = functions_.size();
+            if (cut || test_lines > 2 * tests_.size() + 16) {
+                save();
+            }
+        }
+
+        H2OFT_DECL bool ImpactIndex::save() {
+            // Functions renumbered in order of first use
+            std::vector<uint32_t> ids(functions_.size(), std::numeric_limits<uint32_t>::max());
+            std::vector<uint32_t> used;
+            for (const auto& test : tests_) {
+                for (const auto id : test.second) {
+                    if (ids[id] == std::numeric_limits<uint32_t>::max()) {
+                        ids[id] = static_cast<uint32_t>(used.size());
+                        used.push_back(id);
+                    }
+                }
+            }
+            // The numbers in memory follow the ones of the file, for the next flush()
+            std::vector<Function> functions;
+            function_ids_.clear();
+            for (const auto id : used) {
+                function_ids_.emplace(functions_[id], static_cast<uint32_t>(functions.size()));
+                functions.push_back(std::move(functions_[id]));
+            }
+            functions_ = std::move(functions);
+            for (auto& test : tests_) {
+                for (auto& id : test.second) {
+                    id = ids[id];
+                }
+                std::sort(test.second.begin(), test.second.end());
+            }
+            written_functions_ = functions_.size();
+            pending_tests_.clear();
+
+            std::ostringstream oss;
+            for (const auto& function : functions_) {
+                oss << "F " << function.first << '\t' << function.second << '\n';
+            }
+            for (const auto& test : tests_) {
+                oss << "T " << test.first << '\t';
+                for (size_t index = 0; index < test.second.size(); ++index) {
+                    oss << (index == 0 ? "" : " ") << test.second[index];
+                }
+                oss << '\n';
+            }
+            const auto content = oss.str();
+            // Not saved : the file keeps the former numbers, the next flush() rewrites it
+            rewrite_ = path_.empty() || !write_file_atomically(content.data(), content.size(), path_);
+            return !rewrite_;
+        }
+
+        H2OFT_DECL bool ImpactIndex::flush() {
+            if (path_.empty())
+                return false;
+            if (rewrite_)
+                return save();
+            if (pending_tests_.empty())
+                return true;
+            std::ostringstream oss;
+            for (auto id = written_functions_; id < functions_.size(); ++id) {
+                oss << "F " << functions_[id].first << '\t' << functions_[id].second << '\n';
+            }
+            for (const auto& key : pending_tests_) {
+                const auto& ids = tests_[key];
+                oss << "T " << key << '\t';
+                for (size_t index = 0; index < ids.size(); ++index) {
+                    oss << (index == 0 ? "" : " ") << ids[index];
+                }
+                oss << '\n';
+            }
+            // A single write : the lines of the tests of concurrent scenarios aren't interleaved
+            const auto content = oss.str();
+            std::ofstream file(path_, std::ios::binary | std::ios::app);
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+            file.flush();
+            if (!file)
+                return false;
+            written_functions_ = functions_.size();
+            pending_tests_.clear();
+            return true;
+        }
+
+        H2OFT_DECL void ImpactIndex::record(const std::string& scenario, const std::string& label, const std::vector<Function>& functions) {
+            std::vector<uint32_t> ids;
+            for (const auto& function : functions) {
+                const auto inserted = function_ids_.emplace(function, static_cast<uint32_t>(functions_.size()));
+                if (inserted.second) {
+                    functions_.push_back(function);
+                }
+                ids.push_back(inserted.first->second);
+            }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            tests_[key(scenario, label)] = std::move(ids);
+            pending_tests_.insert(key(scenario, label));
+        }
+
+        H2OFT_DECL bool impact_matches(const ImpactIndex::Function& function, const std::string& change) {
+            const auto& symbol = function.first;
+            const auto& file = function.second;
+            if (change.empty())
+                return false;
+            if (symbol == change || (symbol.size() > change.size() && symbol.compare(0, change.size(), change) == 0
+                && (symbol[change.size()] == '(' || symbol[change.size()] == '<')))
+                return true;
+            return file.size() >= change.size() && file.compare(file.size() - change.size(), change.size(), change) == 0
+                && (file.size() == change.size() || file[file.size() - change.size() - 1] == '/' || file[file.size() - change.size() - 1] == '\\');
+        }
+
+        H2OFT_DECL bool ImpactIndex::isAffected(const std::string& scenario, const std::string& label, const std::vector<std::string>& changes) const {
+            const auto test = tests_.find(key(scenario, label));
+            if (test == tests_.end())
+                return true;
+            return std::any_of(test->second.begin(), test->second.end(), [this, &changes](uint32_t id) {
+                return std::any_of(changes.begin(), changes.end(), [this, id](const std::string& change) { return impact_matches(functions_[id], change); });
+            });
+        }
+
+        H2OFT_DECL std::vector<ScenarioRegistry*>& get_scenarios() {
+            static std::vector<ScenarioRegistry*> scenarios;
+            return scenarios;
+        }
+
+        H2OFT_DECL void Test::run(const SetUpFunctor& setup, const TearDownFunctor& teardown) {
+            current_test() = this;
+            running_test() = this;
+            ++running_tests_count();
+            failure_reason_.clear();
+            error_.clear();
+            histograms_.clear();
+            timings_.clear();
+            failure_sink_.clear();
+            virtual_clock_ = uses_virtual_clock_ ? std::make_shared<VirtualClock>(auto_advance_) : nullptr;
+            {
+                TraceSpan span{ "set_up", "fixture" };
+                const auto start = std::chrono::high_resolution_clock::now();
+                setup();
+                setup_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+            }
+            const auto progress = get_progress().load(std::memory_order_acquire);
+            if (progress != nullptr) {
+                publish_test(*progress, label_);
+            }
+            const auto collect_resource_usage = get_options().collect_resource_usage;
+            const auto usage_before = collect_resource_usage ? resource_usage_snapshot() : ResourceUsage{};
+            {
+                TraceSpan span{ label_, "test" };
+                run_private();
+                resource_usage_ = collect_resource_usage ? resource_usage_snapshot() - usage_before : ResourceUsage{};
+                collect_thread_failures();
+                if (span.isEnabled()) {
+                    std::ostringstream args;
+                    args << "\"status\":\"" << status_ << "\",\"iteration\":" << iteration_;
+                    span.setArgs(args.str());
+                }
+            }
+            {
+                TraceSpan span{ "tear_down", "fixture" };
+                const auto start = std::chrono::high_resolution_clock::now();
+                teardown();
+                teardown_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+            }
+            if (progress != nullptr) {
+                publish_test(*progress, {});
+            }
+            current_test() = nullptr;
+            Test* self = this;
+            running_test().compare_exchange_strong(self, nullptr);
+            --running_tests_count();
+        }
+
+        H2OFT_DECL void Test::collect_thread_failures() {
+            for (const auto& failure : failure_sink_.getFailures()) {
+                if (status_ == Status::PASSED) {
+                    status_ = Status::FAILED;
+                }
+                failure_reason_ += (failure_reason_.empty() ? "" : "\n") + failure;
+            }
+            for (const auto& error : failure_sink_.getErrors()) {
+                if (status_ == Status::PASSED) {
+                    status_ = Status::ERROR;
+                }
+                error_ += (error_.empty() ? "" : "\n") + error;
+            }
+        }
+
+        H2OFT_DECL void Test::run_private() {
+            auto start = std::chrono::high_resolution_clock::now();
+            run_guarded([this]() {
+                (*test_holder_)(); /* /!\ Here is the test call /!\ */
+            });
+            exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+        }
+
+        // 8 bits counters of the modules built with -fsanitize-coverage=inline-8bit-counters, registered at startup
+        struct CoverageCounters {
+            struct Region {
+                uint8_t* begin;
+                uint8_t* end;
+            };
+            Region regions[64];
+            size_t count;
+        };
+
+        H2OFT_DECL CoverageCounters& coverage_counters() {
+            static CoverageCounters counters{};
+            return counters;
+        }
+
+        // Merge the counters hit since the last call into the features seen (a counter per hit count bucket as in libFuzzer),
+        // reset them and returns the number of new features
+        H2OFT_DECL size_t collect_coverage(std::vector<uint8_t>& seen) {
+            const auto& counters = coverage_counters();
+            size_t new_features = 0;
+            size_t index = 0;
+            for (size_t region = 0; region < counters.count; ++region) {
+                for (auto counter = counters.regions[region].begin; counter != counters.regions[region].end; ++counter, ++index) {
+                    if (*counter == 0)
+                        continue;
+                    const auto hits = *counter;
+                    *counter = 0;
+                    const uint8_t bucket = hits >= 128 ? 0x80 : hits >= 32 ? 0x40 : hits >= 16 ? 0x20 : hits >= 8 ? 0x10 : hits >= 4 ? 0x08 : hits == 3 ? 0x04 : hits == 2 ? 0x02 : 0x01;
+                    if (index >= seen.size()) {
+                        seen.resize(index + 1);
+                    }
+                    if ((seen[index] & bucket) == 0) {
+                        seen[index] |= bucket;
+                        ++new_features;
+                    }
+                }
+            }
+            return new_features;
+        }
+
+#if H2OFT_OS_LINUX
+        // Input being run by the fuzz loop : the handler of the fatal signals saves it as the process can't recover
+        struct FuzzCrashState {
+            const uint8_t* data;
+            size_t size;
+            char path[4096];
+        };
+
+        H2OFT_DECL FuzzCrashState& fuzz_crash_state() {
+            static FuzzCrashState state{};
+            return state;
+        }
+
+        H2OFT_DECL void fuzz_signal_handler(int signal_number) {
+            const auto& state = fuzz_crash_state();
+            const auto fd = ::open(state.path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd >= 0) {
+                if (::write(fd, state.data, state.size) < 0) {}
+                ::close(fd);
+            }
+            static const char message[] = "\nH2OFastTests: fatal signal while fuzzing, input saved to ";
+            if (::write(STDERR_FILENO, message, sizeof(message) - 1) < 0 || ::write(STDERR_FILENO, state.path, std::strlen(state.path)) < 0 || ::write(STDERR_FILENO, "\n", 1) < 0) {}
+            ::signal(signal_number, SIG_DFL);
+            ::raise(signal_number);
+        }
+#endif
+
+        H2OFT_DECL FuzzTest::Input read_input(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            return{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        }
+
+        // Save an input under its content hash, returns its path (empty on I/O error)
+        H2OFT_DECL std::string save_input(const std::string& directory, const std::string& prefix, const FuzzTest::Input& input) {
+            std::error_code error;
+            if (!directory.empty()) {
+                std::filesystem::create_directories(directory, error);
+            }
+            std::ostringstream name;
+            name << prefix << std::hex << std::setw(16) << std::setfill('0') << content_hash(reinterpret_cast<const char*>(input.data()), input.size());
+            const auto path = (std::filesystem::path{ directory } / name.str()).string();
+            return write_file_atomically(reinterpret_cast<const char*>(input.data()), input.size(), path) ? path : std::string{};
+        }
+
+        H2OFT_DECL std::string FuzzTest::getReport() const {
+            std::ostringstream oss;
+            oss << executions_ << " runs, " << static_cast<uint64_t>(getExecutionsPerSecond()) << " runs/s, corpus " << inputs_.size() << ", features " << features_;
+            return oss.str();
+        }
+
+        H2OFT_DECL void FuzzTest::run_private() {
+            auto start = std::chrono::high_resolution_clock::now();
+            executions_ = 0;
+            features_ = 0;
+            crash_path_.clear();
+            status_ = Status::PASSED;
+            replay();
+            if (status_ == Status::PASSED && get_options().fuzz) {
+                fuzz();
+            }
+            exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+        }
+
+        H2OFT_DECL Test::Status FuzzTest::execute(const Input& input, std::string& message) {
+            ++executions_;
+#if H2OFT_OS_LINUX
+            fuzz_crash_state().data = input.data();
+            fuzz_crash_state().size = input.size();
+#endif
+            try {
+                fuzz_holder_(input.data(), input.size()); /* /!\ Here is the test call /!\ */
+                return Status::PASSED;
+            }
+            catch (const GenericTestFailure& failure) {
+                message = failure.what();
+                return Status::FAILED;
+            }
+            catch (const std::exception& e) {
+                message = e.what();
+                return Status::ERROR;
+            }
+            catch (...) {
+                message = "Unkown error";
+                return Status::ERROR;
+            }
+        }
+
+        H2OFT_DECL void FuzzTest::replay() {
+            // The empty input, then the corpus and its saved crashes by file name
+            // (the temporary crashes directory of the tests without corpus is shared : never replayed)
+            std::vector<std::string> paths{ std::string{} };
+            for (const auto& directory : { corpus_, corpus_.empty() ? std::string{} : getCrashDirectory() }) {
+                std::error_code error;
+                if (directory.empty() || !std::filesystem::is_directory(directory, error))
+                    continue;
+                std::vector<std::string> files;
+                for (const auto& entry : std::filesystem::directory_iterator{ directory, error }) {
+                    if (entry.is_regular_file(error)) {
+                        files.push_back(entry.path().string());
+                    }
+                }
+                std::sort(files.begin(), files.end());
+                paths.insert(paths.end(), files.begin(), files.end());
+            }
+            inputs_.clear();
+            for (const auto& path : paths) {
+                if (is_cancelled())
+                    break;
+                auto input = path.empty() ? Input{} : read_input(path);
+                std::string message;
+                const auto status = execute(input, message);
+                if (status != Status::PASSED) {
+                    status_ = status;
+                    (status == Status::FAILED ? failure_reason_ : error_) = "[input " + (path.empty() ? std::string{ "<empty>" } : path) + "] " + message;
+                    return;
+                }
+                inputs_.push_back(std::move(input));
+            }
+        }
+
+        H2OFT_DECL void FuzzTest::fuzz() {
+            const auto& options = get_options();
+            std::mt19937_64 rng{ seed_ };
+            // The coverage of the replayed corpus is the starting point
+            std::vector<uint8_t> seen;
+            features_ = collect_coverage(seen);
+#if H2OFT_OS_LINUX
+            const auto signal_path = (std::filesystem::path{ getCrashDirectory() } / "crash-signal").string();
+            std::error_code error;
+            std::filesystem::create_directories(getCrashDirectory(), error);
+            signal_path.copy(fuzz_crash_state().path, sizeof(fuzz_crash_state().path) - 1);
+            fuzz_crash_state().path[std::min(signal_path.size(), sizeof(fuzz_crash_state().path) - 1)] = '\0';
+            const int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+            struct sigaction previous[std::size(signals)];
+            struct sigaction action{};
+            action.sa_handler = fuzz_signal_handler;
+            sigemptyset(&action.sa_mask);
+            for (size_t index = 0; index < std::size(signals); ++index) {
+                sigaction(signals[index], &action, &previous[index]);
+            }
+#endif
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{ options.fuzz_seconds });
+            for (size_t run = 0; !is_cancelled(); ++run) {
+                if (options.fuzz_runs > 0 && run >= options.fuzz_runs)
+                    break;
+                if (options.fuzz_seconds > 0. && run % 256 == 0 && std::chrono::steady_clock::now() >= deadline)
+                    break;
+                auto input = mutate(inputs_[rng() % inputs_.size()], rng);
+                std::string message;
+                const auto status = execute(input, message);
+                if (status != Status::PASSED) {
+                    // The minimized input is kept if it still fails, the verdict is the one of the saved input
+                    auto minimized = minimize(input);
+                    std::string minimized_message;
+                    const auto minimized_status = execute(minimized, minimized_message);
+                    const auto flaky = minimized_status == Status::PASSED;
+                    if (!flaky) {
+                        input = std::move(minimized);
+                        message = std::move(minimized_message);
+                    }
+                    status_ = flaky ? status : minimized_status;
+                    crash_path_ = save_input(getCrashDirectory(), "crash-", input);
+                    std::ostringstream oss;
+                    oss << "[fuzz input of " << input.size() << " bytes saved to " << crash_path_ << " after " << run << " runs"
+                        << (flaky ? ", passed once minimized (flaky)" : "") << "] " << message;
+                    (status_ == Status::FAILED ? failure_reason_ : error_) = oss.str();
+                    break;
+                }
+                const auto new_features = collect_coverage(seen);
+                if (new_features > 0) {
+                    features_ += new_features;
+                    if (!corpus_.empty()) {
+                        save_input(corpus_, "", input);
+                    }
+                    inputs_.push_back(std::move(input));
+                }
+            }
+#if H2OFT_OS_LINUX
+            for (size_t index = 0; index < std::size(signals); ++index) {
+                sigaction(signals[index], &previous[index], nullptr);
+            }
+#endif
+        }
+
+        H2OFT_DECL FuzzTest::Input FuzzTest::mutate(const Input& input, std::mt19937_64& rng) const {
+            static const uint8_t interesting[] = { 0x00, 0x01, 0x7F, 0x80, 0xFF };
+            const auto max_length = std::max<size_t>(get_options().fuzz_max_length, 1);
+            auto result = input;
+            // 1 to 4 stacked mutations
+            for (auto count = 1 + rng() % 4; count > 0; --count) {
+                const auto position = result.empty() ? 0 : static_cast<size_t>(rng() % result.size());
+                switch (result.empty() ? 3 : rng() % 8) {
+                case 0: // Flip a bit
+                    result[position] ^= static_cast<uint8_t>(1u << (rng() % 8));
+                    break;
+                case 1: // Random byte
+                    result[position] = static_cast<uint8_t>(rng());
+                    break;
+                case 2: // Boundary value
+                    result[position] = interesting[rng() % std::size(interesting)];
+                    break;
+                case 3: // Insert a byte
+                    result.insert(result.begin() + static_cast<std::ptrdiff_t>(rng() % (result.size() + 1)), static_cast<uint8_t>(rng()));
+                    break;
+                case 4: { // Erase bytes
+                    const auto length = 1 + rng() % std::min<size_t>(result.size() - position, 16);
+                    result.erase(result.begin() + static_cast<std::ptrdiff_t>(position), result.begin() + static_cast<std::ptrdiff_t>(position + length));
+                    break;
+                }
+                case 5: // Small arithmetic
+                    result[position] = static_cast<uint8_t>(result[position] + static_cast<uint8_t>(rng() % 35) - 17);
+                    break;
+                case 6: { // Duplicate a chunk at another position
+                    const auto length = 1 + rng() % std::min<size_t>(result.size() - position, 64);
+                    const Input chunk{ result.begin() + static_cast<std::ptrdiff_t>(position), result.begin() + static_cast<std::ptrdiff_t>(position + length) };
+                    result.insert(result.begin() + static_cast<std::ptrdiff_t>(rng() % (result.size() + 1)), chunk.begin(), chunk.end());
+                    break;
+                }
+                default: { // Splice with another input of the corpus
+                    const auto& other = inputs_[rng() % inputs_.size()];
+                    result.resize(position);
+                    if (!other.empty()) {
+                        result.insert(result.end(), other.begin() + static_cast<std::ptrdiff_t>(rng() % other.size()), other.end());
+                    }
+                    break;
+                }
+                }
+            }
+            if (result.size() > max_length) {
+                result.resize(max_length);
+            }
+            return result;
+        }
+
+        // Remove chunks of halving sizes while the input still fails
+        H2OFT_DECL FuzzTest::Input FuzzTest::minimize(Input input) {
+            constexpr size_t max_attempts = 4096;
+            size_t attempts = 0;
+            std::string message;
+            for (auto chunk = std::max<size_t>(input.size() / 2, 1); chunk > 0 && attempts < max_attempts; chunk /= 2) {
+                for (size_t offset = 0; offset < input.size() && attempts < max_attempts; ++attempts) {
+                    Input candidate{ input.begin(), input.begin() + static_cast<std::ptrdiff_t>(offset) };
+                    candidate.insert(candidate.end(), input.begin() + static_cast<std::ptrdiff_t>(std::min(offset + chunk, input.size())), input.end());
+                    if (execute(candidate, message) != Status::PASSED) {
+                        input = std::move(candidate);
+                    }
+                    else {
+                        offset += chunk;
+                    }
+                }
+            }
+            return input;
+        }
+
+        H2OFT_DECL std::string FuzzTest::getCrashDirectory() const {
+            return ((corpus_.empty() ? std::filesystem::temp_directory_path() / "h2oft" : std::filesystem::path{ corpus_ }) / "crashes").string();
+        }
+
+        // End of the JSON string starting after position (on its opening quote), or npos if not closed
+        H2OFT_DECL size_t json_string_end(std::string_view text, size_t position) {
+            for (++position; position < text.size(); ++position) {
+                if (text[position] == '\\')
+                    ++position;
+                else if (text[position] == '"')
+                    return position;
+            }
+            return std::string_view::npos;
+        }
+
+        // Value of the key of a JSON object (strings without their quotes, other values as written), empty if missing
+        H2OFT_DECL std::string_view json_value(std::string_view object, std::string_view key) {
+            size_t depth = 0;
+            bool expect_key = false;
+            for (size_t position = 0; position < object.size(); ++position) {
+                const auto c = object[position];
+                if (c == '{' || c == '[') {
+                    ++depth;
+                    expect_key = c == '{' && depth == 1;
+                }
+                else if (c == '}' || c == ']') {
+                    --depth;
+                }
+                else if (c == ',' && depth == 1) {
+                    expect_key = true;
+                }
+                else if (c == '"') {
+                    const auto end = json_string_end(object, position);
+                    if (end == std::string_view::npos)
+                        return {};
+                    const auto name = object.substr(position + 1, end - position - 1);
+                    position = end;
+                    if (!expect_key)
+                        continue;
+                    expect_key = false;
+                    const auto colon = object.find_first_not_of(" \t", end + 1);
+                    if (name != key || colon == std::string_view::npos || object[colon] != ':')
+                        continue;
+                    const auto value = object.find_first_not_of(" \t", colon + 1);
+                    if (value == std::string_view::npos)
+                        return {};
+                    if (object[value] == '"') {
+                        const auto value_end = json_string_end(object, value);
+                        return value_end == std::string_view::npos ? std::string_view{} : object.substr(value + 1, value_end - value - 1);
+                    }
+                    // Number, literal, object or array : up to the ',' or '}' ending it
+                    size_t nested = 0;
+                    auto value_end = value;
+                    for (; value_end < object.size(); ++value_end) {
+                        const auto v = object[value_end];
+                        if (v == '"') {
+                            value_end = std::min(json_string_end(object, value_end), object.size() - 1);
+                        }
+                        else if (v == '{' || v == '[') {
+                            ++nested;
+                        }
+                        else if (v == '}' || v == ']') {
+                            if (nested == 0)
+                                break;
+                            --nested;
+                        }
+                        else if (v == ',' && nested == 0) {
+                            break;
+                        }
+                    }
+                    auto result = object.substr(value, value_end - value);
+                    while (!result.empty() && (result.back() == ' ' || result.back() == '\t')) {
+                        result.remove_suffix(1);
+                    }
+                    return result;
+                }
+            }
+            return {};
+        }
+
+        // Fields of a CSV line, quoted fields without their quotes
+        H2OFT_DECL void split_csv(std::string_view line, std::vector<std::string_view>& fields) {
+            fields.clear();
+            size_t position = 0;
+            while (true) {
+                if (position < line.size() && line[position] == '"') {
+                    auto end = position + 1;
+                    while (end < line.size() && !(line[end] == '"' && (end + 1 == line.size() || line[end + 1] != '"'))) {
+                        end += line[end] == '"' ? 2 : 1;
+                    }
+                    fields.push_back(line.substr(position + 1, std::min(end, line.size()) - position - 1));
+                    position = end < line.size() ? line.find(',', end) : std::string_view::npos;
+                }
+                else {
+                    const auto end = line.find(',', position);
+                    fields.push_back(line.substr(position, end == std::string_view::npos ? std::string_view::npos : end - position));
+                    position = end;
+                }
+                if (position == std::string_view::npos)
+                    break;
+                ++position;
+            }
+        }
+
+        H2OFT_DECL std::string_view DataRow::get(std::string_view name) const {
+            if (header_ == nullptr)
+                return json_value(text_, name);
+            for (size_t index = 0; index < header_->size(); ++index) {
+                if ((*header_)[index] == name)
+                    return (*this)[index];
+            }
+            return {};
+        }
+
+        H2OFT_DECL std::string DataDrivenTest::getReport() const {
+            std::ostringstream oss;
+            oss << rows_ << " rows, " << static_cast<uint64_t>(getRowsPerSecond()) << " rows/s, " << failed_rows_ << " failed";
+            return oss.str();
+        }
+
+        H2OFT_DECL void DataDrivenTest::run_private() {
+            auto start = std::chrono::high_resolution_clock::now();
+            rows_ = 0;
+            failed_rows_ = 0;
+            run_guarded([this]() {
+                const MappedFile file{ path_ };
+                if (!file.isValid())
+                    throw std::runtime_error{ "[DATA] '" + path_ + "' can't be read" };
+                const std::string_view data{ file.getData(), file.getSize() };
+                const auto extension = std::filesystem::path{ path_ }.extension().string();
+                const auto json_lines = extension == ".jsonl" || extension == ".ndjson";
+
+                // The first line of a CSV file names its columns
+                size_t offset = 0;
+                std::vector<std::string_view> header;
+                if (!json_lines) {
+                    const auto end = data.find('\n');
+                    auto line = data.substr(0, end);
+                    if (!line.empty() && line.back() == '\r') {
+                        line.remove_suffix(1);
+                    }
+                    split_csv(line, header);
+                    offset = end == std::string_view::npos ? data.size() : end + 1;
+                }
+
+                // Rows are numbered once the line counts of the chunks before theirs are known
+                // The chunks are numbered in file order : (chunk, line) is the position of the row in the file
+                struct RowFailure {
+                    size_t chunk;
+                    size_t line;
+                    std::string_view text;
+                    std::string message;
+                    bool error;
+                };
+                const auto before = [](const RowFailure& lhs, const RowFailure& rhs) {
+                    return std::tie(lhs.chunk, lhs.line) < std::tie(rhs.chunk, rhs.line);
+                };
+                std::mutex mutex;
+                std::vector<size_t> chunk_lines;
+                std::vector<RowFailure> failures;
+                std::atomic<size_t> rows{ 0 };
+                std::atomic<size_t> failed_rows{ 0 };
+
+                const auto next_chunk = [&](size_t& index, size_t& begin, size_t& end) {
+                    std::lock_guard<std::mutex> lock{ mutex };
+                    if (offset >= data.size() || is_cancelled())
+                        return false;
+                    end = data.find('\n', std::min(offset + chunk_size_, data.size()) - 1);
+                    end = end == std::string_view::npos ? data.size() : end + 1;
+                    begin = offset;
+                    offset = end;
+                    index = chunk_lines.size();
+                    chunk_lines.push_back(0);
+                    return true;
+                };
+                const auto add_failure = [&](size_t chunk, size_t line, std::string_view text, std::string message, bool error) {
+                    failed_rows.fetch_add(1, std::memory_order_relaxed);
+                    // Max-heap of the first failing rows in file order, whatever the order the threads find them in
+                    RowFailure failure{ chunk, line, text, std::move(message), error };
+                    std::lock_guard<std::mutex> lock{ mutex };
+                    if (failures.size() < max_reported_rows_) {
+                        failures.push_back(std::move(failure));
+                        std::push_heap(failures.begin(), failures.end(), before);
+                    }
+                    else if (!failures.empty() && before(failure, failures.front())) {
+                        std::pop_heap(failures.begin(), failures.end(), before);
+                        failures.back() = std::move(failure);
+                        std::push_heap(failures.begin(), failures.end(), before);
+                    }
+                };
+                const auto worker = [&]() {
+                    const auto previous_test = current_test();
+                    current_test() = this;
+                    DataRow row;
+                    row.header_ = json_lines ? nullptr : &header;
+                    size_t executed = 0;
+                    size_t index = 0;
+                    size_t begin = 0;
+                    size_t end = 0;
+                    while (next_chunk(index, begin, end)) {
+                        size_t lines = 0;
+                        for (auto position = begin; position < end; ++lines) {
+                            auto line_end = data.find('\n', position);
+                            line_end = line_end == std::string_view::npos ? end : line_end;
+                            auto text = data.substr(position, line_end - position);
+                            position = line_end + 1;
+                            if (!text.empty() && text.back() == '\r') {
+                                text.remove_suffix(1);
+                            }
+                            if (text.empty())
+                                continue;
+                            row.text_ = text;
+                            if (!json_lines) {
+                                split_csv(text, row.fields_);
+                            }
+                            ++executed;
+                            try {
+                                rows_holder_(row); /* /!\ Here is the test call /!\ */
+                            }
+                            catch (const GenericTestFailure& failure) {
+                                add_failure(index, lines, text, failure.what(), false);
+                            }
+                            catch (const std::exception& e) {
+                                add_failure(index, lines, text, e.what(), true);
+                            }
+                            catch (...) {
+                                add_failure(index, lines, text, "Unkown error", true);
+                            }
+                        }
+                        std::lock_guard<std::mutex> lock{ mutex };
+                        chunk_lines[index] = lines;
+                    }
+                    rows.fetch_add(executed, std::memory_order_relaxed);
+                    current_test() = previous_test;
+                };
+                std::vector<std::thread> workers;
+                for (size_t job = 1; job < get_options().jobs; ++job) {
+                    workers.emplace_back(worker);
+                }
+                worker();
+                for (auto& thread : workers) {
+                    thread.join();
+                }
+
+                rows_ = rows;
+                failed_rows_ = failed_rows;
+                std::vector<size_t> first_lines(chunk_lines.size());
+                size_t line = json_lines ? 1 : 2;
+                for (size_t index = 0; index < chunk_lines.size(); ++index) {
+                    first_lines[index] = line;
+                    line += chunk_lines[index];
+                }
+                std::sort_heap(failures.begin(), failures.end(), before);
+                bool any_failure = false;
+                for (const auto& failure : failures) {
+                    std::ostringstream oss;
+                    oss << "[" << path_ << ":" << first_lines[failure.chunk] + failure.line << "] "
+                        << (failure.text.size() > 200 ? std::string{ failure.text.substr(0, 200) } + "..." : std::string{ failure.text }) << " : " << failure.message;
+                    if (failure.error) {
+                        failure_sink_.addError(oss.str());
+                    }
+                    else {
+                        failure_sink_.addFailure(oss.str());
+                        any_failure = true;
+                    }
+                }
+                if (failed_rows_ > failures.size()) {
+                    const auto more = "[" + path_ + "] " + std::to_string(failed_rows_ - failures.size()) + " more failing rows";
+                    if (any_failure) {
+                        failure_sink_.addFailure(more);
+                    }
+                    else {
+                        failure_sink_.addError(more);
+                    }
+                }
+            });
+            exec_time_ms_ = std::chrono::high_resolution_clock::now() - start;
+        }
+
+        // Functions entered by each test while Options::impact_record is set (see __cyg_profile_func_enter)
+        // Never destroyed : instrumented static destructors still call the hook at exit
+        struct ImpactRecorder {
+            std::atomic<bool> recording{ false };
+            std::mutex mutex;
+            std::map<const Test*, std::unordered_set<const void*>> functions;
+        };
+
+        H2OFT_DECL H2OFT_NO_INSTRUMENT ImpactRecorder& impact_recorder() {
+            static auto recorder = new ImpactRecorder;
+            return *recorder;
+        }
+
+        // Set while the hook runs on the thread : the functions it calls may be instrumented too (std containers)
+        // The functions the hook reaches before it is set are H2OFT_NO_INSTRUMENT
+        H2OFT_DECL H2OFT_NO_INSTRUMENT bool& impact_busy() {
+            thread_local bool busy = false;
+            return busy;
+        }
+
+        // Functions entered by the thread for its current test, merged into the recorder when the test changes
+        struct ImpactThreadBuffer {
+            const Test* test = nullptr;
+            std::unordered_set<const void*> functions;
+
+            H2OFT_NO_INSTRUMENT void flush() {
+                if (test != nullptr && !functions.empty()) {
+                    auto& recorder = impact_recorder();
+                    std::lock_guard<std::mutex> lock{ recorder.mutex };
+                    recorder.functions[test].insert(functions.begin(), functions.end());
+                }
+                functions.clear();
+            }
+
+            H2OFT_NO_INSTRUMENT ~ImpactThreadBuffer() {
+                impact_busy() = true;
+                flush();
+            }
+        };
+
+        H2OFT_DECL H2OFT_NO_INSTRUMENT ImpactThreadBuffer& impact_thread_buffer() {
+            thread_local ImpactThreadBuffer buffer;
+            return buffer;
+        }
+
+        H2OFT_DECL H2OFT_NO_INSTRUMENT void impact_enter(const void* function) {
+            auto& busy = impact_busy();
+            if (busy)
+                return;
+            busy = true;
+            if (impact_recorder().recording.load(std::memory_order_relaxed)) {
+                // Only the threads running a test (test body, TestThread, loop callback) are attributed
+                const Test* test = current_test();
+                if (test != nullptr) {
+                    auto& buffer = impact_thread_buffer();
+                    if (buffer.test != test) {
+                        buffer.flush();
+                        buffer.test = test;
+                    }
+                    buffer.functions.insert(function);
+                }
+            }
+            busy = false;
+        }
+
+        H2OFT_DECL H2OFT_NO_INSTRUMENT std::vector<const void*> take_impact_functions(const Test* test) {
+            auto& busy = impact_busy();
+            busy = true;
+            impact_thread_buffer().flush();
+            auto& recorder = impact_recorder();
+            std::vector<const void*> functions;
+            {
+                std::lock_guard<std::mutex> lock{ recorder.mutex };
+                const auto recorded = recorder.functions.find(test);
+                if (recorded != recorder.functions.end()) {
+                    functions.assign(recorded->second.begin(), recorded->second.end());
+                    recorder.functions.erase(recorded);
+                }
+            }
+            busy = false;
+            return functions;
+        }
+
+        // Symbol and source file of the instrumented functions : addr2line on the module of each function (Linux)
+        // Resolved once per run, the caller holds get_impact_mutex()
+        H2OFT_DECL std::vector<ImpactIndex::Function> resolve_functions(const std::vector<const void*>& addresses) {
+            static std::map<const void*, ImpactIndex::Function> cache;
+#if H2OFT_OS_LINUX
+            std::map<std::string, std::vector<std::pair<const void*, uintptr_t>>> modules;
+            for (const auto address : addresses) {
+                Dl_info info;
+                if (cache.count(address) > 0 || dladdr(address, &info) == 0 || info.dli_fname == nullptr || info.dli_fbase == nullptr)
+                    continue;
+                // Addresses of shared objects and PIE are relative to their load address
+                const auto header = static_cast<const ElfW(Ehdr)*>(info.dli_fbase);
+                const auto offset = reinterpret_cast<uintptr_t>(address) - (header->e_type == ET_EXEC ? 0 : reinterpret_cast<uintptr_t>(info.dli_fbase));
+                std::error_code error;
+                const std::string module = std::filesystem::exists(info.dli_fname, error) ? info.dli_fname : "/proc/self/exe";
+                modules[module].emplace_back(address, offset);
+                if (info.dli_sname != nullptr) {
+                    int status = 0;
+                    const auto demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                    cache[address].first = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+                    std::free(demangled);
+                }
+            }
+            for (const auto& module : modules) {
+                std::string quoted_module;
+                for (const auto c : module.first) {
+                    quoted_module += c == '\'' ? std::string{ "'\\''" } : std::string(1, c);
+                }
+                constexpr size_t batch = 256;
+                for (size_t begin = 0; begin < module.second.size(); begin += batch) {
+                    const auto end = std::min(begin + batch, module.second.size());
+                    std::ostringstream command;
+                    command << "addr2line -f -C -e '" << quoted_module << "'" << std::hex;
+                    for (auto index = begin; index < end; ++index) {
+                        command << " 0x" << module.second[index].second;
+                    }
+                    command << " 2>/dev/null";
+                    const auto pipe = ::popen(command.str().c_str(), "r");
+                    if (pipe == nullptr)
+                        continue;
+                    // Two lines per address : the function, then file:line
+                    std::vector<std::string> lines;
+                    char buffer[4096];
+                    while (std::fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+                        lines.emplace_back(buffer);
+                        while (!lines.back().empty() && (lines.back().back() == '\n' || lines.back().back() == '\r')) {
+                            lines.back().pop_back();
+                        }
+                    }
+                    ::pclose(pipe);
+                    for (auto index = begin; index < end && 2 * (index - begin) + 1 < lines.size(); ++index) {
+                        auto& function = cache[module.second[index].first];
+                        const auto& symbol = lines[2 * (index - begin)];
+                        auto file = lines[2 * (index - begin) + 1];
+                        if (symbol != "??") {
+                            function.first = symbol;
+                        }
+                        file = file.substr(0, file.find(" (discriminator"));
+                        file = file.substr(0, file.rfind(':'));
+                        function.second = file == "??" ? std::string{} : file;
+                    }
+                }
+            }
+#endif
+            std::vector<ImpactIndex::Function> functions;
+            for (const auto address : addresses) {
+                auto& function = cache[address];
+                if (function.first.empty()) {
+                    std::ostringstream oss;
+                    oss << address;
+                    function.first = oss.str();
+                }
+                functions.push_back(function);
+            }
+            return functions;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::run_tests() {
+            TraceSpan span{ name_, "scenario" };
+            // The unowned failures raised until the end of the scenario fail it
+            const auto unowned_before = unowned_failure_count();
+            const auto& setup = get_registry().getSetUp(index_);
+            const auto& teardown = get_registry().getTearDown(index_);
+            auto& tests = get_registry().getTests(index_);
+            const auto& options = get_options();
+            const auto seed = get_seed();
+            std::vector<Test*> order;
+            for (auto& test : tests) {
+                if (test->getLabel(false).find(options.filter) != std::string::npos) {
+                    order.push_back(test.get());
+                }
+            }
+            if (options.impact_select) {
+                // The tests affected by the changes (or never recorded), with their prerequisites
+                std::lock_guard<std::mutex> lock{ get_impact_mutex() };
+                auto& index = get_impact_index();
+                index.open(options.impact_index);
+                std::set<std::string> selected;
+                for (auto test : order) {
+                    if (index.isAffected(name_, test->getLabel(false), options.impact_changes)) {
+                        selected.insert(test->getLabel(false));
+                    }
+                }
+                for (auto added = true; added;) {
+                    added = false;
+                    for (auto test : order) {
+                        if (selected.count(test->getLabel(false)) > 0) {
+                            for (const auto& prerequisite : test->prerequisites_) {
+                                added = selected.insert(prerequisite).second || added;
+                            }
+                        }
+                    }
+                }
+                order.erase(std::remove_if(order.begin(), order.end(), [&selected](Test* test) { return selected.count(test->getLabel(false)) == 0; }), order.end());
+            }
+            if (options.impact_record) {
+                impact_recorder().recording = true;
+            }
+            open_progress(options.progress_file);
+            publish_progress(order.size());
+            if (options.shuffle) {
+                std::shuffle(order.begin(), order.end(), std::mt19937_64{ seed });
+            }
+            order = order_by_prerequisites(order);
+            std::vector<AsyncTest*> async_tests;
+            for (auto test : order) {
+                if (is_cancelled()) {
+                    cancel(*test);
+                    record(*test);
+                    continue;
+                }
+                // A test runs only if all its prerequisites passed (async tests run last and can't be prerequisites)
+                const auto find_test = [&order](const std::string& label) {
+                    return std::find_if(order.begin(), order.end(), [&label](Test* candidate) { return candidate->getLabel(false) == label; });
+                };
+                const auto async_prerequisite = std::find_if(test->prerequisites_.begin(), test->prerequisites_.end(), [&](const std::string& label) {
+                    const auto prerequisite = find_test(label);
+                    return prerequisite != order.end() && dynamic_cast<AsyncTest*>(*prerequisite) != nullptr;
+                });
+                if (async_prerequisite != test->prerequisites_.end()) {
+                    skip(*test, {});
+                    test->status_ = Test::Status::ERROR;
+                    test->error_ = "Prerequisite test '" + *async_prerequisite + "' is an async test : async tests run last and can't be prerequisites";
+                    record(*test);
+                    continue;
+                }
+                const auto unmet = std::find_if(test->prerequisites_.begin(), test->prerequisites_.end(), [&](const std::string& label) {
+                    const auto prerequisite = find_test(label);
+                    return prerequisite == order.end() || (*prerequisite)->getStatus() != Test::Status::PASSED;
+                });
+                if (unmet != test->prerequisites_.end()) {
+                    skip(*test, "Prerequisite test '" + *unmet + "' did not pass");
+                    record(*test);
+                    continue;
+                }
+                if (options.repeat > 1 || options.first_iteration > 0) {
+                    // Async tests included : each iteration runs alone on an event loop
+                    run_repeated(*test, setup, teardown, seed);
+                }
+                else if (auto async_test = dynamic_cast<AsyncTest*>(test)) {
+                    async_test->seed_ = iteration_seed(seed, test->label_, 0);
+                    async_test->iteration_ = 0;
+                    async_tests.push_back(async_test);
+                    continue;
+                }
+                else {
+                    test->seed_ = iteration_seed(seed, test->label_, 0);
+                    test->iteration_ = 0;
+                    test->run(setup, teardown);
+                    if (options.shuffle) {
+                        annotate_failure(*test, replay_info(seed, 0));
+                    }
+                }
+                record(*test);
+            }
+            // The async tests run concurrently once the others are done
+            if (is_cancelled()) {
+                for (auto test : async_tests) {
+                    cancel(*test);
+                    record(*test);
+                }
+                async_tests.clear();
+            }
+            if (!async_tests.empty()) {
+                AsyncTest::run_all(async_tests, setup, teardown, options.async_threads);
+                for (auto test : async_tests) {
+                    record(*test);
+                }
+            }
+            if (options.impact_record && !options.impact_index.empty()) {
+                // Only the tests run this time are updated in the index
+                std::lock_guard<std::mutex> lock{ get_impact_mutex() };
+                auto& index = get_impact_index();
+                index.open(options.impact_index);
+                for (auto test : order) {
+                    const auto status = test->getStatus();
+                    if (status == Test::Status::PASSED || status == Test::Status::FAILED || status == Test::Status::ERROR) {
+                        index.record(name_, test->getLabel(false), resolve_functions(take_impact_functions(test)));
+                    }
+                }
+                index.flush();
+            }
+            const auto unowned = get_unowned_failures();
+            unowned_failures_.assign(unowned.begin() + static_cast<std::ptrdiff_t>(unowned_before), unowned.end());
+            run_ = true;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::skip_tests(const std::string& reason) {
+            open_progress(get_options().progress_file);
+            publish_progress(get_registry().getTests(index_).size());
+            for (auto& test : get_registry().getTests(index_)) {
+                skip(*test, reason);
+                record(*test);
+            }
+            prerequisites_failed_ = true;
+            run_ = true;
+        }
+
+        H2OFT_DECL std::vector<Test*> ScenarioRegistry::order_by_prerequisites(const std::vector<Test*>& tests) {
+            // Stable : a test is only moved after the prerequisites it's waiting for
+            std::vector<Test*> ordered;
+            std::set<Test*> placed;
+            auto is_placed = [&](const std::string& label) {
+                const auto prerequisite = std::find_if(tests.begin(), tests.end(), [&label](Test* candidate) { return candidate->getLabel(false) == label; });
+                return prerequisite == tests.end() || placed.count(*prerequisite) > 0;
+            };
+            while (ordered.size() < tests.size()) {
+                const auto count = ordered.size();
+                for (auto test : tests) {
+                    if (placed.count(test) == 0 && std::all_of(test->prerequisites_.begin(), test->prerequisites_.end(), is_placed)) {
+                        ordered.push_back(test);
+                        placed.insert(test);
+                    }
+                }
+                if (ordered.size() == count) {
+                    // Circular prerequisites : the remaining tests will be skipped
+                    for (auto test : tests) {
+                        if (placed.insert(test).second) {
+                            ordered.push_back(test);
+                        }
+                    }
+                }
+            }
+            return ordered;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::cancel_tests() {
+            open_progress(get_options().progress_file);
+            publish_progress(get_registry().getTests(index_).size());
+            for (auto& test : get_registry().getTests(index_)) {
+                cancel(*test);
+                record(*test);
+            }
+            run_ = true;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::cancel(Test& test) {
+            skip(test, "Run cancelled: " + get_cancellation_token().getReason());
+            test.status_ = Test::Status::CANCELLED;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::skip(Test& test, const std::string& reason) {
+            test.status_ = Test::Status::SKIPPED;
+            test.skipped_reason_ = reason;
+            test.failure_reason_.clear();
+            test.error_.clear();
+            test.exec_time_ms_ = Duration{ 0 };
+        }
+
+        H2OFT_DECL std::map<std::string, Timing> ScenarioRegistry::getAllTestsTimings() const {
+            std::map<std::string, Timing> timings;
+            if (run_) {
+                for (const auto& test : getAllTests()) {
+                    for (const auto& timing : test->getTimings()) {
+                        timings[timing.first] += timing.second;
+                    }
+                }
+            }
+            return timings;
+        }
+
+        H2OFT_DECL void ScenarioRegistry::record(const Test& test) {
+            exec_time_ms_accumulator_ += test.getExecTimeMs();
+            setup_time_ms_accumulator_ += test.getSetUpTimeMs();
+            teardown_time_ms_accumulator_ += test.getTearDownTimeMs();
+            notify(TestInfo{ test });
+            results_.add(test, scenario_id_);
+            if (test.getStatus() == Test::Status::FAILED || test.getStatus() == Test::Status::ERROR) {
+                get_cancellation_token().addFailure(get_options().fail_fast);
+            }
+            if (const auto progress = get_progress().load(std::memory_order_acquire)) {
+                const auto failed = test.getStatus() == Test::Status::FAILED || test.getStatus() == Test::Status::ERROR;
+                switch (test.getStatus()) {
+                case Test::Status::PASSED: progress->passed.fetch_add(1, std::memory_order_relaxed); break;
+                case Test::Status::FAILED: progress->failed.fetch_add(1, std::memory_order_relaxed); break;
+                case Test::Status::ERROR: progress->errors.fetch_add(1, std::memory_order_relaxed); break;
+                case Test::Status::SKIPPED: progress->skipped.fetch_add(1, std::memory_order_relaxed); break;
+                case Test::Status::CANCELLED: progress->cancelled.fetch_add(1, std::memory_order_relaxed); break;
+                default: break;
+                }
+                if (progress_ != nullptr) {
+                    progress_->done.fetch_add(1, std::memory_order_relaxed);
+                    progress_->failed.fetch_add(failed ? 1 : 0, std::memory_order_relaxed);
+                }
+                progress->done.fetch_add(1, std::memory_order_release);
+                progress->elapsed_ns.store(progress_time_ns() - progress->start_time_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+
+        H2OFT_DECL void ScenarioRegistry::publish_progress(size_t tests) {
+            progress_ = nullptr;
+            const auto progress = get_progress().load(std::memory_order_acquire);
+            if (progress == nullptr)
+                return;
+            progress->total.fetch_add(tests, std::memory_order_relaxed);
+            const auto index = progress->scenario_count.fetch_add(1);
+            if (index >= ProgressFile::max_scenarios)
+                return;
+            progress_ = &progress->scenarios[index];
+            progress_->total.store(tests, std::memory_order_relaxed);
+            publish_string(progress_->sequence, progress_->name, sizeof(progress_->name), name_);
+        }
+
+        H2OFT_DECL std::string ScenarioRegistry::replay_info(uint64_t seed, size_t iteration) {
+            std::ostringstream oss;
+            oss << "[seed " << seed << ", iteration " << iteration << "] ";
+            return oss.str();
+        }
+
+        H2OFT_DECL void ScenarioRegistry::annotate_failure(Test& test, const std::string& info) {
+            if (test.status_ == Test::Status::FAILED) {
+                test.failure_reason_ = info + test.failure_reason_;
+            }
+            else if (test.status_ == Test::Status::ERROR) {
+                test.error_ = info + test.error_;
+            }
+        }
+
+        H2OFT_DECL void ScenarioRegistry::run_repeated(Test& test, const SetUpFunctor& setup, const TearDownFunctor& teardown, uint64_t seed) {
+            const auto& options = get_options();
+            const auto first = options.first_iteration;
+            const auto last = first + std::max<size_t>(options.repeat, 1);
+            // Run by the worker drawing the first iteration
+            auto first_repeat = test.clone();
+            if (!first_repeat) {
+                // Can't be cloned (stress, fuzz, data-driven, async tests, benchmarks) : the iterations run one after
+                // the other on the test itself, until the first failure which is kept
+                size_t runs = 0;
+                Duration exec_time{ 0 };
+                for (auto iteration = first; iteration < last && !is_cancelled(); ++iteration) {
+                    test.seed_ = iteration_seed(seed, test.label_, iteration);
+                    test.iteration_ = iteration;
+                    test.run(setup, teardown);
+                    ++runs;
+                    exec_time += test.getExecTimeMs();
+                    if (test.status_ == Test::Status::FAILED || test.status_ == Test::Status::ERROR)
+                        break;
+                }
+                if (runs == 0) {
+                    // Cancelled before the first repeat
+                    cancel(test);
+                    return;
+                }
+                const auto failed = test.status_ == Test::Status::FAILED || test.status_ == Test::Status::ERROR;
+                test.exec_time_ms_ = exec_time;
+                std::ostringstream oss;
+                oss << replay_info(seed, test.iteration_) << "[failed " << (failed ? 1 : 0) << "/" << runs << " repeats, run sequentially] ";
+                annotate_failure(test, oss.str());
+                return;
+            }
+            std::atomic<size_t> next{ first };
+            std::atomic<bool> stop{ false };
+            std::mutex mutex;
+            std::unique_ptr<Test> failed, last_run;
+            size_t failures = 0, runs = 0;
+            Duration exec_time{ 0 };
+            auto worker = [&]() {
+                for (auto iteration = next++; iteration < last && !stop && !is_cancelled(); iteration = next++) {
+                    auto repeat = iteration == first ? std::move(first_repeat) : test.clone();
+                    repeat->seed_ = iteration_seed(seed, test.label_, iteration);
+                    repeat->iteration_ = iteration;
+                    repeat->run(setup, teardown);
+                    const auto status = repeat->getStatus();
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++runs;
+                    exec_time += repeat->getExecTimeMs();
+                    if (status == Test::Status::FAILED || status == Test::Status::ERROR) {
+                        ++failures;
+                        stop = stop || options.until_fail;
+                        if (!failed || repeat->iteration_ < failed->iteration_) {
+                            failed = std::move(repeat);
+                        }
+                    }
+                    else if (!last_run || repeat->iteration_ > last_run->iteration_) {
+                        last_run = std::move(repeat);
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t job = 1; job < std::min(options.jobs, last - first); ++job) {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : workers) {
+                thread.join();
+            }
+
+            if (!failed && !last_run) {
+                // Cancelled before the first repeat
+                cancel(test);
+                return;
+            }
+            const auto& result = failed ? *failed : *last_run;
+            test.status_ = result.status_;
+            test.failure_reason_ = result.failure_reason_;
+            test.error_ = result.error_;
+            test.histograms_ = result.histograms_;
+            test.timings_ = result.timings_;
+            test.setup_time_ms_ = result.setup_time_ms_;
+            test.teardown_time_ms_ = result.teardown_time_ms_;
+            test.resource_usage_ = result.resource_usage_;
+            test.seed_ = result.seed_;
+            test.iteration_ = result.iteration_;
+            test.exec_time_ms_ = exec_time;
+            std::ostringstream oss;
+            oss << replay_info(seed, result.iteration_) << "[failed " << failures << "/" << runs << " repeats] ";
+            annotate_failure(test, oss.str());
+        }
+
+        H2OFT_DECL void run_scenarios(size_t threads) {
+            auto& scenarios = get_scenarios();
+            const auto count = scenarios.size();
+            std::map<std::string, size_t> indices;
+            for (size_t index = 0; index < count; ++index) {
+                indices[scenarios[index]->getName()] = index;
+            }
+            // Number of prerequisites each scenario waits for, and the scenarios waiting for each one
+            std::vector<size_t> waiting(count, 0);
+            std::vector<std::vector<size_t>> dependents(count);
+            for (size_t index = 0; index < count; ++index) {
+                for (const auto& name : scenarios[index]->getPrerequisites()) {
+                    const auto prerequisite = indices.find(name);
+                    if (prerequisite != indices.end()) {
+                        ++waiting[index];
+                        dependents[prerequisite->second].push_back(index);
+                    }
+                }
+            }
+
+            // Draw the seed before the workers race for it
+            get_seed();
+
+            std::mutex mutex;
+            std::condition_variable done_cv;
+            std::vector<size_t> ready;
+            std::vector<bool> done(count, false);
+            size_t done_count = 0, running = 0;
+            for (size_t index = 0; index < count; ++index) {
+                if (waiting[index] == 0) {
+                    ready.push_back(index);
+                }
+            }
+
+            auto unmet_prerequisite = [&](const ScenarioRegistry& scenario) -> std::string {
+                for (const auto& name : scenario.getPrerequisites()) {
+                    const auto prerequisite = indices.find(name);
+                    if (prerequisite == indices.end()) {
+                        return "Unknown prerequisite scenario '" + name + "'";
+                    }
+                    if (!scenarios[prerequisite->second]->hasPassed()) {
+                        return "Prerequisite scenario '" + name + "' did not pass";
+                    }
+                }
+                return{};
+            };
+
+            auto worker = [&]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (done_count < count) {
+                    if (ready.empty()) {
+                        if (running == 0) {
+                            // Nothing running nor ready : the remaining scenarios wait on each other
+                            for (size_t index = 0; index < count; ++index) {
+                                if (!done[index]) {
+                                    if (!scenarios[index]->hasRun()) {
+                                        scenarios[index]->skip_tests("Circular prerequisites between scenarios");
+                                    }
+                                    done[index] = true;
+                                    ++done_count;
+                                }
+                            }
+                            done_cv.notify_all();
+                        }
+                        else {
+                            done_cv.wait(lock);
+                        }
+                        continue;
+                    }
+                    const auto index = ready.front();
+                    ready.erase(ready.begin());
+                    ++running;
+                    auto& scenario = *scenarios[index];
+                    const auto reason = unmet_prerequisite(scenario);
+                    lock.unlock();
+                    if (!scenario.hasRun()) {
+                        if (is_cancelled()) {
+                            scenario.cancel_tests();
+                        }
+                        else if (reason.empty()) {
+                            scenario.run_tests();
+                        }
+                        else {
+                            scenario.skip_tests(reason);
+                        }
+                    }
+                    lock.lock();
+                    --running;
+                    if (!done[index]) {
+                        done[index] = true;
+                        ++done_count;
+                    }
+                    for (auto dependent : dependents[index]) {
+                        if (--waiting[dependent] == 0 && !done[dependent]) {
+                            ready.push_back(dependent);
+                        }
+                    }
+                    done_cv.notify_all();
+                }
+            };
+
+            if (threads == 0) {
+                threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            }
+            std::vector<std::thread> workers;
+            for (size_t index = 1; index < std::min(threads, count); ++index) {
+                workers.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : workers) {
+                thread.join();
+            }
+        }
+
+        H2OFT_DECL std::string timing_summary(const Timing& timing) {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(6) << timing.count << " calls, total " << timing.total.count() << " ms, mean " << timing.getMean().count()
+                << " ms, min " << timing.min.count() << " ms, max " << timing.max.count() << " ms";
+            return oss.str();
+        }
+
+        H2OFT_DECL void print_summary(const ScenarioRegistry& registry_manager, const std::string& test_name, bool verbose) {
+            ColoredPrintf(COLOR_CYAN, "UNIT TEST SUMMARY [%s] [%.6f ms] : \n", test_name.substr(test_name.find(' ') + 1).c_str(), registry_manager.getAllTestsExecTimeMs().count());
+
+            const auto& options = detail::get_options();
+            if (options.shuffle || options.repeat > 1 || options.first_iteration > 0) {
+                ColoredPrintf(COLOR_CYAN, "\tSEED: %llu, REPEAT: %zu from iteration %zu\n", static_cast<unsigned long long>(options.seed), options.repeat, options.first_iteration);
+            }
+
+            if (verbose) {
+                ColoredPrintf(COLOR_CYAN, "\tPHASES: set_up %.6f ms, body %.6f ms, tear_down %.6f ms\n", registry_manager.getAllTestsSetUpTimeMs().count(),
+                    registry_manager.getAllTestsExecTimeMs().count(), registry_manager.getAllTestsTearDownTimeMs().count());
+            }
+            for (const auto& timing : registry_manager.getAllTestsTimings()) {
+                ColoredPrintf(COLOR_CYAN, "\tTIMER [%s]: %s\n", timing.first.c_str(), timing_summary(timing.second).c_str());
+            }
+
+            const auto has_benchmarks = std::any_of(registry_manager.getAllTests().begin(), registry_manager.getAllTests().end(), [](const auto& test) {
+                return dynamic_cast<const detail::Benchmark*>(test.get()) != nullptr;
+            });
+            if (has_benchmarks && registry_manager.hasRun()) {
+                std::string warnings;
+                for (const auto& warning : detail::get_benchmark_storage().getEnvironmentWarnings()) {
+                    warnings += (warnings.empty() ? "" : ", ") + warning;
+                }
+                if (!warnings.empty()) {
+                    ColoredPrintf(COLOR_YELLOW, "\tNOISY ENVIRONMENT: %s\n", warnings.c_str());
+                }
+            }
+
+            detail::ResourceUsage resource_usage;
+            for (const auto& test : registry_manager.getAllTests()) {
+                resource_usage += test->getResourceUsage();
+            }
+            if (resource_usage.collected) {
+                std::ostringstream oss;
+                oss << resource_usage;
+                ColoredPrintf(COLOR_CYAN, "\tRESOURCES: %s\n", oss.str().c_str());
+            }
+
+            if (registry_manager.getPassedCount() > 0) {
+                ColoredPrintf(COLOR_GREEN, "\tPASSED: %d/%d\n", registry_manager.getPassedCount(), registry_manager.getAllTestsCount());
+                if (verbose) {
+                    for (const auto& test : registry_manager.getPassedTests()) {
+                        ColoredPrintf(COLOR_GREEN, "\t\t[%s] [%.6f ms]\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count());
+                        if (const auto benchmark = dynamic_cast<const detail::Benchmark*>(&test.get())) {
+                            ColoredPrintf(COLOR_GREEN, "\t\tBenchmark: %s\n", benchmark->getReport().c_str());
+                        }
+                        if (const auto fuzz_test = dynamic_cast<const detail::FuzzTest*>(&test.get())) {
+                            ColoredPrintf(COLOR_GREEN, "\t\tFuzz: %s\n", fuzz_test->getReport().c_str());
+                        }
+                        if (const auto data_test = dynamic_cast<const detail::DataDrivenTest*>(&test.get())) {
+                            ColoredPrintf(COLOR_GREEN, "\t\tData: %s\n", data_test->getReport().c_str());
+                        }
+                        ColoredPrintf(COLOR_GREEN, "\t\tPhases: set_up %.6f ms, tear_down %.6f ms\n", test.get().getSetUpTimeMs().count(), test.get().getTearDownTimeMs().count());
+                        for (const auto& timing : test.get().getTimings()) {
+                            ColoredPrintf(COLOR_GREEN, "\t\tTimer [%s]: %s\n", timing.first.c_str(), timing_summary(timing.second).c_str());
+                        }
+                        for (const auto& histogram : test.get().getHistograms()) {
+                            ColoredPrintf(COLOR_GREEN, "\t\tHistogram [%s]: %s\n", histogram.first.c_str(), histogram.second.getSummary().c_str());
+                        }
+                        if (test.get().getResourceUsage().collected) {
+                            std::ostringstream oss;
+                            oss << test.get().getResourceUsage();
+                            ColoredPrintf(COLOR_GREEN, "\t\tResources: %s\n", oss.str().c_str());
+                        }
+                    }
+                }
+            }
+
+            if (registry_manager.getFailedCount() > 0) {
+                ColoredPrintf(COLOR_RED, "\tFAILED: %d/%d\n", registry_manager.getFailedCount(), registry_manager.getAllTestsCount());
+                // Always print failed tests
+                for (const auto& test : registry_manager.getFailedTests()) {
+                    ColoredPrintf(COLOR_RED, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getFailureReason().c_str());
+                }
+            }
+
+            if (!registry_manager.getUnownedFailures().empty()) {
+                ColoredPrintf(COLOR_RED, "\tUNOWNED FAILURES: %zu (threads without test, while several tests ran)\n", registry_manager.getUnownedFailures().size());
+                for (const auto& failure : registry_manager.getUnownedFailures()) {
+                    ColoredPrintf(COLOR_RED, "\t\tMessage: %s\n", failure.c_str());
+                }
+            }
+
+            if (registry_manager.getSkippedCount() > 0) {
+                ColoredPrintf(COLOR_YELLOW, "\tSKIPPED: %d/%d\n", registry_manager.getSkippedCount(), registry_manager.getAllTestsCount());
+                if (verbose) {
+                    for (const auto& test : registry_manager.getSkippedTests()) {
+                        ColoredPrintf(COLOR_YELLOW, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getSkippedReason().c_str());
+                    }
+                }
+            }
+
+            if (registry_manager.getWithErrorCount() > 0) {
+                ColoredPrintf(COLOR_PURPLE, "\tERRORS: %d/%d\n", registry_manager.getWithErrorCount(), registry_manager.getAllTestsCount());
+                // Always print error tests
+                for (const auto& test : registry_manager.getWithErrorTests()) {
+                    ColoredPrintf(COLOR_PURPLE, "\t\t[%s] [%.6f ms]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getExecTimeMs().count(), test.get().getError().c_str());
+                }
+            }
+
+            if (registry_manager.getCancelledCount() > 0) {
+                ColoredPrintf(COLOR_BLUE, "\tCANCELLED: %d/%d\n", registry_manager.getCancelledCount(), registry_manager.getAllTestsCount());
+                if (verbose) {
+                    for (const auto& test : registry_manager.getCancelledTests()) {
+                        ColoredPrintf(COLOR_BLUE, "\t\t[%s]\n\t\tMessage: %s\n", test.get().getLabel(verbose).c_str(), test.get().getSkippedReason().c_str());
+                    }
+                }
+            }
+        }
+
+    }
+
+    H2OFT_DECL void ConsoleIO_Observer::update(TestInfo infos) const {
+        // Scenarios run by run_all_scenarios() report concurrently
+        static std::mutex mutex;
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto status = infos.get().getStatus();
+        std::cout << (status == Test::Status::SKIPPED ? "SKIPPING TEST [" : status == Test::Status::CANCELLED ? "CANCELLED TEST [" : "RUNNING TEST [")
+            << infos.get().getLabel(false) << "] [" << infos.get().getExecTimeMs().count() << "ms]:" << std::endl
+            << "Status: " << infos.get().getStatus() << std::endl;
+        if (const auto benchmark = dynamic_cast<const Benchmark*>(&infos.get())) {
+            std::cout << "Benchmark: " << benchmark->getReport() << std::endl;
+        }
+        if (const auto fuzz_test = dynamic_cast<const FuzzTest*>(&infos.get())) {
+            std::cout << "Fuzz: " << fuzz_test->getReport() << std::endl;
+        }
+        if (const auto data_test = dynamic_cast<const DataDrivenTest*>(&infos.get())) {
+            std::cout << "Data: " << data_test->getReport() << std::endl;
+        }
+        for (const auto& timing : infos.get().getTimings()) {
+            std::cout << "Timer [" << timing.first << "]: " << detail::timing_summary(timing.second) << std::endl;
+        }
+        for (const auto& histogram : infos.get().getHistograms()) {
+            std::cout << "Histogram [" << histogram.first << "]: " << histogram.second.getSummary() << std::endl;
+        }
+        if (infos.get().getResourceUsage().collected) {
+            std::cout << "Resources: " << infos.get().getResourceUsage() << std::endl;
+        }
+    }
+
+}
+
+#if !H2OFT_OS_WINDOWS
+// Called on each function entry and exit by the code built with -finstrument-functions (test impact analysis)
+// Weak : a profiler linked in the binary takes precedence
+extern "C" __attribute__((weak, no_instrument_function)) void __cyg_profile_func_enter(void* function, void* /*call_site*/) {
+    H2OFastTests::detail::impact_enter(function);
+}
+
+extern "C" __attribute__((weak, no_instrument_function)) void __cyg_profile_func_exit(void* /*function*/, void* /*call_site*/) {}
+
+#if defined(H2OFT_SEPARATE_COMPILATION) || defined(H2OFT_COVERAGE_HOOK)
+// Called at startup by the modules built with -fsanitize-coverage=inline-8bit-counters to register their counters
+// Weak : a fuzzing engine linked in the binary takes precedence
+// Defined once by src/H2OFastTests.cpp, or by the test TU defining H2OFT_COVERAGE_HOOK when header-only
+extern "C" __attribute__((weak)) void __sanitizer_cov_8bit_counters_init(char* begin, char* end) {
+    auto& counters = H2OFastTests::detail::coverage_counters();
+    if (counters.count < std::size(counters.regions)) {
+        counters.regions[counters.count++] = { reinterpret_cast<uint8_t*>(begin), reinterpret_cast<uint8_t*>(end) };
+    }
+}
+#endif
+#endif
+
+#endif
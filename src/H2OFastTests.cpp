@@ -0,0 +1,31 @@
+/*
+ *
+ *  (C) Copyright 2016 Michaël Roynard
+ *
+ *  Distributed under the MIT License, Version 1.0. (See accompanying
+ *  file LICENSE or copy at https://opensource.org/licenses/MIT)
+ *
+ *  See https://github.com/dutiona/H2OFastTests for documentation.
+ */
+
+// Runtime of H2OFastTests compiled once (H2OFT_SEPARATE_COMPILATION), instead of inline in every test TU
+
+#include "H2OFastTests.hpp"
+#include "H2OFastTests_impl.hpp"
+
+namespace H2OFastTests {
+    namespace detail {
+
+        template void FailureTest<bool, bool>(bool, bool, bool, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<int, int>(bool, int, int, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<unsigned int, unsigned int>(bool, unsigned int, unsigned int, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<long, long>(bool, long, long, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<unsigned long, unsigned long>(bool, unsigned long, unsigned long, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<long long, long long>(bool, long long, long long, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<unsigned long long, unsigned long long>(bool, unsigned long long, unsigned long long, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<float, float>(bool, float, float, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<double, double>(bool, double, double, FailureType, const std::string&, const LineInfo&);
+        template void FailureTest<std::string, std::string>(bool, std::string, std::string, FailureType, const std::string&, const LineInfo&);
+
+    }
+}
@@ -0,0 +1,68 @@
+/*
+*
+*  (C) Copyright 2016 Michal Roynard
+*
+*  Distributed under the MIT License, Version 1.0. (See accompanying
+*  file LICENSE or copy at https://opensource.org/licenses/MIT)
+*
+*  See https://github.com/dutiona/H2OFastTests for documentation.
+*/
+
+// Built header-only with -finstrument-functions : the hook and the whole runtime it reaches are instrumented,
+// as in a test binary recording the test impact analysis index
+
+#include "H2OFastTests.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+
+// Stand for functions of the code under test
+__attribute__((noinline)) void impact_target() {
+    asm volatile("");
+}
+
+__attribute__((noinline)) void impact_raw_thread_target() {
+    asm volatile("");
+}
+
+register_scenario(H2OFastTests_Impact)
+{
+    add_test("ImpactIndex(recorded function)", []() {
+        impact_target();
+    });
+
+    add_test("ImpactIndex(no function)", []() {});
+
+    add_test("ImpactIndex(raw thread)", []() {
+        std::thread{ impact_raw_thread_target }.join();
+    });
+
+    add_test("ImpactIndex(test thread)", []() {
+        H2OFastTests::TestThread{ impact_target }.join();
+    });
+}
+
+int main() {
+    auto& options = H2OFastTests::get_options();
+    options.impact_index = (std::filesystem::temp_directory_path() / "h2oft_impact_recording.idx").string();
+    std::filesystem::remove(options.impact_index);
+    options.impact_record = true;
+    register_observer(H2OFastTests_Impact, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_Impact);
+    options.impact_record = false;
+    print_result(H2OFastTests_Impact);
+
+    auto& impact_index = H2OFastTests::detail::get_impact_index();
+    impact_index.open(options.impact_index);
+    const auto failures =
+        H2OFastTests_Impact_registry_manager.getFailedCount() + H2OFastTests_Impact_registry_manager.getWithErrorCount() +
+        (impact_index.isAffected("H2OFastTests_Impact", "ImpactIndex(recorded function)", { "impact_target" }) ? 0 : 1) +
+        (impact_index.isAffected("H2OFastTests_Impact", "ImpactIndex(no function)", { "impact_target" }) ? 1 : 0) +
+        // A thread without test isn't attributed to the test that started it
+        (impact_index.isAffected("H2OFastTests_Impact", "ImpactIndex(raw thread)", { "impact_raw_thread_target" }) ? 1 : 0) +
+        (impact_index.isAffected("H2OFastTests_Impact", "ImpactIndex(test thread)", { "impact_target" }) ? 0 : 1);
+    std::filesystem::remove(options.impact_index);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
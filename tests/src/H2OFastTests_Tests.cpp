@@ -10,9 +10,25 @@
 
 #include "H2OFastTests.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace H2OFastTests::Asserter;
 
@@ -132,6 +148,87 @@ register_scenario(H2OFastTests_Tests)
         AssertThat(false).isFalse("Expect true != false");
     });
 
+    add_test("TestThread(assertion passed)", []() {
+        H2OFastTests::TestThread thread([]() {
+            AssertThat(1).isEqualTo(1, "Expect 1 == 1");
+        });
+    });
+
+    add_test("TestThread(assertion failed)", []() {
+        {
+            H2OFastTests::TestThread thread([]() {
+                AssertThat(1).isEqualTo(2, "Expect 1 == 2");
+            });
+        }
+        auto& sink = H2OFastTests::detail::current_test()->getFailureSink();
+        const auto failures = sink.getFailures();
+        sink.clear();
+        AssertThat(failures.size()).isEqualTo(size_t{ 1 }, "Expect the failure to be forwarded to the test");
+        AssertThat(failures.front().find("Expect 1 == 2") != std::string::npos).isTrue("Expect the failure message");
+    });
+
+    add_test("std::thread(assertion failed)", []() {
+        bool continued = false;
+        std::thread thread([&continued]() {
+            AssertThat(1).isEqualTo(2, "Expect 1 == 2");
+            continued = true;
+        });
+        thread.join();
+        auto& sink = H2OFastTests::detail::current_test()->getFailureSink();
+        const auto failures = sink.getFailures();
+        sink.clear();
+        AssertThat(failures.size()).isEqualTo(size_t{ 1 }, "Expect the failure to be reported to the running test");
+        AssertThat(continued).isTrue("Expect the thread to continue after the failure");
+    });
+
+    add_test("StressTest::stress_point(outside of a stress test)", []() {
+        H2OFastTests::stress_point();
+        AssertThat(H2OFastTests::detail::current_perturbation()).isNull("Expect no perturbation outside of a stress test");
+    });
+
+    auto stress_counter = std::make_shared<std::atomic<size_t>>(0);
+    add_stress_test("StressTest(std::atomic::fetch_add)", 4, 10000, [stress_counter](size_t thread_index, size_t) {
+        const auto before = stress_counter->fetch_add(1);
+        H2OFastTests::stress_point();
+        AssertThat(stress_counter->load() > before).isTrue("Expect the counter to only grow");
+        AssertThat(thread_index < 4).isTrue("Expect 4 threads");
+    }).perturb(0.01, 100);
+
+    add_stress_test("StressTest::perturb(seeded from the test seed)", 1, 1, [](size_t, size_t) {
+        AssertThat(H2OFastTests::detail::current_perturbation()->rng_state).isEqualTo(H2OFastTests::test_seed() + 1, "Expect the perturbation of the thread 0 to be seeded from the test seed");
+    }).perturb(0.5);
+
+    add_test("Assert::matchesSnapshot(std::vector<uint8_t>)", []() {
+        const auto path = (std::filesystem::temp_directory_path() / "h2oft_snapshot_vector.bin").string();
+        std::vector<uint8_t> buffer(1 << 20);
+        for (size_t i = 0; i < buffer.size(); ++i) {
+            buffer[i] = static_cast<uint8_t>(i * 31);
+        }
+        AssertThat(H2OFastTests::detail::write_snapshot(reinterpret_cast<const char*>(buffer.data()), buffer.size(), path)).isTrue("Expect the snapshot to be written");
+        AssertThat(buffer).matchesSnapshot(path, "Expect the buffer to match its hash");
+        std::filesystem::remove(path + ".hash");
+        AssertThat(buffer).matchesSnapshot(path, "Expect the buffer to match the snapshot content");
+        std::filesystem::remove(path);
+    });
+
+    add_test("Assert::matchesSnapshot(mismatch)", []() {
+        const auto path = (std::filesystem::temp_directory_path() / "h2oft_snapshot_string.txt").string();
+        std::string buffer(4096, 'a');
+        AssertThat(H2OFastTests::detail::write_snapshot(buffer.data(), buffer.size(), path)).isTrue("Expect the snapshot to be written");
+        buffer[1000] = 'b';
+        std::string failure;
+        try {
+            AssertThat(buffer).matchesSnapshot(path);
+        }
+        catch (const H2OFastTests::detail::GenericTestFailure& e) {
+            failure = e.what();
+        }
+        std::filesystem::remove(path);
+        std::filesystem::remove(path + ".hash");
+        AssertThat(failure.find("differs at byte offset 1000") != std::string::npos).isTrue("Expect the offset of the first difference");
+        AssertThat(failure.find("61 61 62<61") != std::string::npos).isTrue("Expect the hex window around the difference");
+    });
+
     add_test("Assert::ExceptException<CustomException>", []() {
         AssertThat([]() {
             throw CustomException{};
@@ -141,11 +238,922 @@ register_scenario(H2OFastTests_Tests)
     });
 }
 
-int main(int /*argc*/, char** /*argv*/) {
+register_scenario(H2OFastTests_Benchmarks)
+{
+    auto make_samples = [](double base, double step) {
+        std::vector<double> samples;
+        for (int i = 0; i < 30; ++i) {
+            samples.push_back(base + step * ((i * 7) % 30));
+        }
+        return samples;
+    };
+
+    add_test("Benchmark::compare_samples(regressed)", [make_samples]() {
+        auto comparison = H2OFastTests::detail::compare_samples(make_samples(1., 0.001), make_samples(1.2, 0.001), 0.01);
+        AssertThat(comparison.verdict).isEqualTo(H2OFastTests::BenchmarkVerdict::REGRESSED, "Expect +20% to be a regression");
+        AssertThat(comparison.shift).isEqualTo(0.2, 0.01, "Expect a shift of 20%");
+        AssertThat(comparison.shift_low <= comparison.shift && comparison.shift <= comparison.shift_high).isTrue("Expect shift within its confidence interval");
+    });
+
+    add_test("Benchmark::compare_samples(improved)", [make_samples]() {
+        auto comparison = H2OFastTests::detail::compare_samples(make_samples(1., 0.001), make_samples(0.9, 0.001), 0.01);
+        AssertThat(comparison.verdict).isEqualTo(H2OFastTests::BenchmarkVerdict::IMPROVED, "Expect -10% to be an improvement");
+    });
+
+    add_test("Benchmark::compare_samples(unchanged)", [make_samples]() {
+        auto comparison = H2OFastTests::detail::compare_samples(make_samples(1., 0.01), make_samples(1.001, 0.01), 0.01);
+        AssertThat(comparison.verdict).isEqualTo(H2OFastTests::BenchmarkVerdict::UNCHANGED, "Expect overlapping samples to be unchanged");
+    });
+
+    add_test("Benchmark::best_fit_complexity(n log n)", []() {
+        std::vector<std::pair<double, double>> points;
+        for (double n = 16; n <= 1 << 20; n *= 2) {
+            points.emplace_back(n, 3e-6 * n * std::log2(n) + 1e-4);
+        }
+        auto fit = H2OFastTests::detail::best_fit_complexity(points);
+        AssertThat(fit.complexity).isEqualTo(H2OFastTests::O_NLogN, "Expect n log n samples to fit O(n log n)");
+        AssertThat(fit.coefficient).isEqualTo(3e-6, 1e-7, "Expect coefficient of 3e-6");
+    });
+
+    add_test("Benchmark::best_fit_complexity(n^2)", []() {
+        std::vector<std::pair<double, double>> points;
+        for (double n = 16; n <= 1 << 12; n *= 2) {
+            points.emplace_back(n, 1e-6 * n * n + 1e-6 * n);
+        }
+        AssertThat(H2OFastTests::detail::best_fit_complexity(points).complexity).isEqualTo(H2OFastTests::O_N2, "Expect quadratic samples to fit O(n^2)");
+    });
+
+    add_test("Histogram::getValueAtPercentile()", []() {
+        H2OFastTests::Histogram histogram;
+        for (uint64_t value = 1; value <= 100000; ++value) {
+            histogram.recordValue(value * 1000); // 1us to 100ms
+        }
+        AssertThat(histogram.getTotalCount()).isEqualTo(uint64_t{ 100000 }, "Expect 100000 values");
+        AssertThat(histogram.getValueAtPercentile(50.).count()).isEqualTo(50., 50. / 64., "Expect p50 ~50ms");
+        AssertThat(histogram.getValueAtPercentile(99.).count()).isEqualTo(99., 99. / 64., "Expect p99 ~99ms");
+        AssertThat(histogram.getMax().count()).isEqualTo(100., 1e-9, "Expect exact max");
+    });
+
+    add_test("Histogram::save()/load()", []() {
+        H2OFastTests::Histogram first, second;
+        for (uint64_t value = 0; value < 1000; ++value) {
+            first.recordValue(value);
+            second.recordValue(value + 1000000);
+        }
+        std::stringstream exported;
+        second.save(exported);
+        AssertThat(first.load(exported)).isTrue("Expect the exported histogram to be loaded");
+        AssertThat(first.getTotalCount()).isEqualTo(uint64_t{ 2000 }, "Expect merged counts");
+        AssertThat(first.getValueAtPercentile(50.).count()).isEqualTo(0.999e-3, 1e-9, "Expect p50 of the merged histogram");
+        AssertThat(first.getMax().count()).isEqualTo(1.000999, 1e-9, "Expect max of the merged histogram");
+    });
+
+    add_test("Histogram::load(malformed)", []() {
+        for (const auto& input : { "H2OFastTests-histogram v1 7 1 5 5\nx 1\nend\n", "H2OFastTests-histogram v1 7 1 5 5\n5x 1\nend\n",
+            "H2OFastTests-histogram v1 7 1 5 5\n99999999999999999999999 1\nend\n" }) {
+            H2OFastTests::Histogram histogram;
+            std::stringstream imported{ input };
+            AssertThat(histogram.load(imported)).isFalse("Expect a malformed bucket index to be rejected");
+        }
+    });
+
+    add_test("Histogram::test_histogram()", []() {
+        auto& histogram = H2OFastTests::test_histogram("push_back");
+        std::vector<int> values;
+        for (int i = 0; i < 1000; ++i) {
+            const auto start = std::chrono::high_resolution_clock::now();
+            values.push_back(i);
+            histogram.record(std::chrono::high_resolution_clock::now() - start);
+        }
+        AssertThat(histogram.getTotalCount()).isEqualTo(uint64_t{ 1000 }, "Expect 1000 values");
+    });
+
+    add_test("Histogram::test_histogram(TestThread)", []() {
+        {
+            std::vector<std::unique_ptr<H2OFastTests::TestThread>> threads;
+            for (int thread = 0; thread < 4; ++thread) {
+                threads.push_back(std::make_unique<H2OFastTests::TestThread>([thread]() {
+                    for (int i = 0; i < 100; ++i) {
+                        H2OFastTests::test_histogram("thread " + std::to_string(thread)).recordValue(1);
+                    }
+                }));
+            }
+        }
+        const auto& histograms = H2OFastTests::detail::current_test()->getHistograms();
+        AssertThat(histograms.size()).isEqualTo(size_t{ 4 }, "Expect the histograms of every thread");
+        AssertThat(histograms.at("thread 3").getTotalCount()).isEqualTo(uint64_t{ 100 }, "Expect the values of the thread");
+    });
+
+    add_test("AsserterExpression::matches()", []() {
+        const std::vector<int> values{ 1, 2, 3 };
+        AssertThat(values).matches(allOf(hasSize(3), contains(2), not_(contains(4))), "Expect the vector to match");
+        AssertThat(values).matches(allOf(hasSize(inRange(size_t{ 1 }, size_t{ 5 })), contains(inRange(3, 5))), "Expect the nested matchers to match");
+        AssertThat(std::string{ "H2OFastTests" }).matches(anyOf(hasSize(0), contains("Fast")), "Expect the substring to be found");
+        AssertThat(5).matches(allOf(inRange(1, 10), not_(7), matchesPredicate([](int value) { return value % 2 == 1; }, "odd")), "Expect 5 to match");
+        AssertThat(0.1 + 0.2).matches(near(0.3, 1e-9), "Expect 0.1 + 0.2 to be near 0.3");
+        const double expected = 0.3;
+        const int low = 0;
+        AssertThat(0.1 + 0.2).matches(allOf(near(expected, 1e-9), inRange(low, 10)), "Expect lvalue bounds of mixed types");
+    });
+
+    add_test("AsserterExpression::matches(contains owns its text)", []() {
+        const std::vector<std::string> values{ "a", std::string(40, 'c') };
+        // The temporary strings are gone when the matchers are used
+        const auto text = contains(std::string(40, 'c'));
+        const auto matcher = contains(equalTo(std::string(40, 'c')));
+        AssertThat(values).matches(text, "Expect the owned text to be found");
+        AssertThat(values).matches(matcher, "Expect the nested matcher to match");
+        AssertThat(std::string(50, 'c')).matches(text, "Expect the owned substring to be found");
+    });
+
+    add_test("AsserterExpression::matches(failure described)", []() {
+        std::string what;
+        try {
+            AssertThat(12).matches(allOf(inRange(1, 10), not_(12)), "Expect 12 to match");
+        }
+        catch (const H2OFastTests::detail::GenericTestFailure& failure) {
+            what = failure.what();
+        }
+        AssertThat(what).matches(allOf(contains("[REACHED] 12"), contains("[EXPECTED TO MATCH] all of (in range [1, 10], not equal to 12)")),
+            "Expect the failing matcher to be described");
+    });
+
+    add_test("ScopedTimer::scoped_timer()", []() {
+        for (int i = 0; i < 3; ++i) {
+            scoped_timer("parse");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const auto& timings = H2OFastTests::detail::current_test()->getTimings();
+        AssertThat(timings.count("parse")).isEqualTo(size_t{ 1 }, "Expect the timer to be recorded");
+        AssertThat(timings.at("parse").count).isEqualTo(size_t{ 3 }, "Expect the 3 scopes to be timed");
+        AssertThat(timings.at("parse").min.count() >= 1.).isTrue("Expect each scope to last the sleep");
+    });
+
+    add_test("ScopedTimer::scoped_timer(TestThread)", []() {
+        {
+            H2OFastTests::TestThread thread([]() {
+                for (int i = 0; i < 1000; ++i) {
+                    scoped_timer("thread");
+                }
+            });
+            // Read while the thread is still timing
+            for (int i = 0; i < 100; ++i) {
+                H2OFastTests::DoNotOptimize(H2OFastTests::detail::current_test()->getTimings().size());
+            }
+        }
+        AssertThat(H2OFastTests::detail::current_test()->getTimings().at("thread").count).isEqualTo(size_t{ 1000 }, "Expect every scope of the thread to be timed");
+    });
+
+    add_test("ResourceUsage::resource_usage_snapshot()", []() {
+        const auto before = H2OFastTests::detail::resource_usage_snapshot();
+        std::vector<char> pages(16 << 20);
+        for (size_t i = 0; i < pages.size(); i += 4096) {
+            pages[i] = static_cast<char>(i);
+        }
+        H2OFastTests::DoNotOptimize(pages.data());
+        const auto usage = H2OFastTests::detail::resource_usage_snapshot() - before;
+        if (usage.collected) {
+            AssertThat(usage.minor_faults >= 1000).isTrue("Expect touching 16MB to page-fault");
+            AssertThat(usage.user_time + usage.system_time > H2OFastTests::detail::Duration{ 0 }).isTrue("Expect CPU time to be used");
+        }
+    });
+
+    add_test("BenchmarkState::pauseTiming()", []() {
+        H2OFastTests::BenchmarkState state;
+        state.pauseTiming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        state.resumeTiming();
+        AssertThat(state.getPausedTime() >= std::chrono::milliseconds(2)).isTrue("Expect paused time >= 2ms");
+    });
+
+    add_test("Benchmark::coefficient_of_variation()", []() {
+        AssertThat(H2OFastTests::coefficient_of_variation({ 10., 10., 10. })).isEqualTo(0., "Expect no dispersion");
+        AssertThat(H2OFastTests::coefficient_of_variation({ 42. })).isEqualTo(0., "Expect a single sample to be stable");
+        AssertThat(std::abs(H2OFastTests::coefficient_of_variation({ 9., 11. }) - std::sqrt(2.) / 10.) < 1e-9).isTrue("Expect sample stddev / mean");
+    });
+
+#if H2OFT_OS_LINUX
+    add_test("BenchmarkEnvironment(pinned)", []() {
+        auto& storage = H2OFastTests::detail::get_benchmark_storage();
+        const auto previous = storage.getCpuAffinity();
+        cpu_set_t before;
+        sched_getaffinity(0, sizeof(before), &before);
+        storage.setCpuAffinity({ 0 });
+        {
+            const H2OFastTests::BenchmarkEnvironment environment;
+            cpu_set_t pinned;
+            sched_getaffinity(0, sizeof(pinned), &pinned);
+            AssertThat(CPU_COUNT(&pinned) == 1 && CPU_ISSET(0, &pinned)).isTrue("Expect the benchmark to be pinned to cpu 0");
+        }
+        storage.setCpuAffinity(previous);
+        cpu_set_t after;
+        sched_getaffinity(0, sizeof(after), &after);
+        AssertThat(CPU_EQUAL(&before, &after) != 0).isTrue("Expect the affinity to be restored");
+    });
+#endif
+
+    add_benchmark("Benchmark::std::sort(1024 int)", [](H2OFastTests::BenchmarkState& state) {
+        state.pauseTiming();
+        std::vector<int> values(1024);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<int>((i * 7919) % 1024);
+        }
+        state.resumeTiming();
+        std::sort(values.begin(), values.end());
+        H2OFastTests::DoNotOptimize(values.data());
+        H2OFastTests::ClobberMemory();
+        state.setItemsProcessed(values.size());
+        state.setBytesProcessed(values.size() * sizeof(int));
+    }, 10).recordLatencies();
+
+    // First touch of 1MB : fresh memory and cold caches for the cold samples, next to the warm ones
+    add_benchmark("Benchmark::first touch(1MB)", [](H2OFastTests::BenchmarkState& state) {
+        constexpr size_t size = 1 << 20;
+        auto memory = state.getMemory(size);
+        for (size_t i = 0; i < size; i += 64) {
+            memory[i] = static_cast<char>(i);
+        }
+        H2OFastTests::DoNotOptimize(memory);
+        H2OFastTests::ClobberMemory();
+        state.setBytesProcessed(size);
+    }, 10).coldCache(true, size_t{ 8 } << 20);
+
+    add_complexity_benchmark("Benchmark::first touch(n bytes)", [](H2OFastTests::BenchmarkState& state) {
+        auto memory = state.getMemory(state.getRange());
+        for (size_t i = 0; i < state.getRange(); i += 64) {
+            memory[i] = static_cast<char>(i);
+        }
+        H2OFastTests::DoNotOptimize(memory);
+        H2OFastTests::ClobberMemory();
+    }, 1 << 12, 1 << 16, 4, 5).coldCache(true, size_t{ 8 } << 20);
+
+    add_complexity_benchmark("Benchmark::std::sort(n int)", [](H2OFastTests::BenchmarkState& state) {
+        state.pauseTiming();
+        std::vector<int> values(state.getRange());
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<int>((i * 7919) % values.size());
+        }
+        state.resumeTiming();
+        std::sort(values.begin(), values.end());
+        H2OFastTests::DoNotOptimize(values.data());
+    }, 1 << 6, 1 << 14, 4).expectComplexity(H2OFastTests::O_NLogN);
+
+    add_threaded_benchmark("Benchmark::std::atomic::fetch_add(shared counter)", [](H2OFastTests::BenchmarkState& state) {
+        static std::atomic<size_t> counter{ 0 };
+        for (size_t i = 0; i < 1024; ++i) {
+            counter.fetch_add(state.getThreadIndex() + 1, std::memory_order_relaxed);
+        }
+    }, 4, 5);
+}
+
+// Calls of the repeated tests that can't be cloned
+std::atomic<size_t> repeated_stress_calls{ 0 };
+std::atomic<size_t> repeated_async_calls{ 0 };
+
+register_scenario(H2OFastTests_Repeats)
+{
+    add_test("Options::seed(iteration_seed)", []() {
+        const auto seed = H2OFastTests::detail::iteration_seed(42, "label", 7);
+        AssertThat(H2OFastTests::detail::iteration_seed(42, "label", 7)).isEqualTo(seed, "Expect the same seed for the same iteration");
+        AssertThat(H2OFastTests::detail::iteration_seed(42, "label", 8)).isNotEqualTo(seed, "Expect another seed for another iteration");
+        AssertThat(seed).isEqualTo(uint64_t{ 4018203919120833151ull }, "Expect the same seed with every compiler and standard library");
+    });
+
+    add_test("Options::repeat(test_seed)", []() {
+        const auto seed = H2OFastTests::test_seed();
+        const auto test = H2OFastTests::detail::current_test();
+        AssertThat(seed).isEqualTo(H2OFastTests::detail::iteration_seed(H2OFastTests::get_options().seed, test->getLabel(false), test->getIteration()), "Expect the seed of the iteration");
+    });
+
+    add_test("Options::repeat(std::mt19937 from test_seed)", []() {
+        std::mt19937_64 rng{ H2OFastTests::test_seed() };
+        std::vector<int> values(64);
+        for (auto& value : values) {
+            value = static_cast<int>(rng() % 1000);
+        }
+        std::sort(values.begin(), values.end());
+        AssertThat(std::is_sorted(values.begin(), values.end())).isTrue("Expect sorted values");
+    });
+
+    add_stress_test("Options::repeat(StressTest, not clonable)", 2, 1, [](size_t, size_t) {
+        ++repeated_stress_calls;
+    });
+
+    add_async_test("Options::repeat(AsyncTest, not clonable)", []() {
+        ++repeated_async_calls;
+        return std::async(std::launch::async, []() {});
+    });
+}
+
+register_scenario(H2OFastTests_Benchmarks_Threaded_Cold)
+{
+    // Rejected with an error instead of silently measuring warm caches only
+    add_threaded_benchmark("ThreadedBenchmark::coldCache()", [](H2OFastTests::BenchmarkState&) {}, 2, 1).coldCache();
+}
+
+// Fulfilled by one async test, waited on by many others
+std::promise<void> async_shared_promise;
+const std::shared_future<void> async_shared_future = async_shared_promise.get_future().share();
+
+register_scenario(H2OFastTests_Async)
+{
+    add_async_test("AsyncTest(std::async future)", []() {
+        return std::async(std::launch::async, []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            AssertThat(1 + 1).isEqualTo(2, "Expect the assert to pass on the std::async thread");
+        });
+    });
+
+    // Waited on by the single future waiter of each loop, not a thread per test
+    for (auto index = 0; index < 200; ++index) {
+        add_async_test("AsyncTest(shared future) #" + std::to_string(index), []() { return async_shared_future; });
+    }
+    add_async_test("AsyncTest(promise fulfilled)", []() {
+        return std::async(std::launch::async, []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            async_shared_promise.set_value();
+        });
+    });
+
+#if H2OFT_HAS_COROUTINES
+    // Each test sleeps 100ms : run concurrently they take about 100ms in all
+    for (auto index = 0; index < 4; ++index) {
+        add_async_test("AsyncTest(async_sleep) #" + std::to_string(index), []() -> H2OFastTests::AsyncTask {
+            const auto start = std::chrono::steady_clock::now();
+            co_await H2OFastTests::async_sleep(H2OFastTests::detail::Duration{ 100 });
+            AssertThat(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100)).isTrue("Expect to be resumed after the sleep");
+        });
+    }
+
+    add_async_test("AsyncTest(co_await AsyncTask)", []() -> H2OFastTests::AsyncTask {
+        auto sleep_and_check = [](int value) -> H2OFastTests::AsyncTask {
+            co_await H2OFastTests::async_sleep(H2OFastTests::detail::Duration{ 10 });
+            AssertThat(value).isEqualTo(42, "Expect the sub task to run with its argument");
+        };
+        co_await sleep_and_check(42);
+    });
+
+#if H2OFT_OS_LINUX
+    add_async_test("AsyncTest(async_readable)", []() -> H2OFastTests::AsyncTask {
+        int fds[2];
+        AssertThat(pipe(fds) == 0).isTrue("Expect the pipe to be created");
+        std::thread writer([fd = fds[1]]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const char value = 'x';
+            (void)write(fd, &value, 1);
+        });
+        co_await H2OFastTests::async_readable(fds[0]);
+        char value = 0;
+        const auto read_count = read(fds[0], &value, 1);
+        writer.join();
+        close(fds[0]);
+        close(fds[1]);
+        AssertThat(read_count).isEqualTo(1, "Expect a byte to be readable");
+        AssertThat(value).isEqualTo('x', "Expect the written byte");
+    });
+#endif
+#endif
+}
+
+// The body of the timed out test runs until released by main, then sets done
+std::promise<void> async_timed_out_release;
+std::atomic<bool> async_timed_out_body_done{ false };
+// Never fulfilled
+std::promise<void> async_never_fulfilled;
+
+register_scenario(H2OFastTests_Async_Timeout)
+{
+    add_async_test("AsyncTest(std::async future timed out)", []() {
+        return std::async(std::launch::async, []() {
+            async_timed_out_release.get_future().wait();
+            async_timed_out_body_done = true;
+        });
+    }, H2OFastTests::detail::Duration{ 10 });
+
+    add_async_test("AsyncTest(promise never fulfilled)", []() {
+        return async_never_fulfilled.get_future();
+    }, H2OFastTests::detail::Duration{ 10 });
+}
+
+// Corpus written by main before running the scenario
+const auto fuzz_corpus = (std::filesystem::temp_directory_path() / "h2oft_fuzz_corpus").string();
+
+register_scenario(H2OFastTests_Fuzz)
+{
+    add_fuzz_test("FuzzTest(corpus replay)", [](const uint8_t* data, size_t size) {
+        AssertThat(size <= 3).isTrue("Expect the inputs of the corpus");
+        AssertThat(std::find(data, data + size, uint8_t{ 0x42 }) == data + size).isTrue("Expect no 0x42 byte");
+    }, fuzz_corpus);
+}
+
+register_scenario(H2OFastTests_Fuzzing)
+{
+    add_fuzz_test("FuzzTest(0x42 byte found and minimized)", [](const uint8_t* data, size_t size) {
+        AssertThat(std::find(data, data + size, uint8_t{ 0x42 }) == data + size).isTrue("Expect no 0x42 byte");
+    }, fuzz_corpus);
+}
+
+register_scenario(H2OFastTests_Fuzzing_Flaky)
+{
+    add_fuzz_test("FuzzTest(flaky failure, no corpus)", [](const uint8_t* data, size_t size) {
+        // Only the first input with a 0x42 byte fails : the minimization and the re-execution pass
+        static bool failed = false;
+        if (!failed && std::find(data, data + size, uint8_t{ 0x42 }) != data + size) {
+            failed = true;
+            AssertThat(false).isTrue("Expect no 0x42 byte the first time");
+        }
+    });
+}
+
+const auto data_csv = (std::filesystem::temp_directory_path() / "h2oft_cases.csv").string();
+const auto data_jsonl = (std::filesystem::temp_directory_path() / "h2oft_cases.jsonl").string();
+
+register_scenario(H2OFastTests_DataDriven)
+{
+    add_data_driven_test("DataDrivenTest(CSV, 2 wrong rows)", data_csv, [](const H2OFastTests::DataRow& row) {
+        const auto a = std::stoi(std::string{ row.get("a") });
+        const auto b = std::stoi(std::string{ row[1] });
+        AssertThat(a + b).isEqualTo(std::stoi(std::string{ row.get("sum") }), "Expect the sum of the row");
+    }).setChunkSize(4096);
+
+    add_data_driven_test("DataDrivenTest(CSV, first wrong row reported)", data_csv, [](const H2OFastTests::DataRow& row) {
+        const auto a = std::stoi(std::string{ row.get("a") });
+        if (a == 4) {
+            // Found last : the other thread reaches the end of the file meanwhile
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        AssertThat(a + std::stoi(std::string{ row[1] })).isEqualTo(std::stoi(std::string{ row.get("sum") }), "Expect the sum of the row");
+    }).setChunkSize(4096).setMaxReportedRows(1);
+
+    add_data_driven_test("DataDrivenTest(JSON lines)", data_jsonl, [](const H2OFastTests::DataRow& row) {
+        AssertThat(std::string{ row.get("expected") }).isEqualTo(std::string{ "3" }, "Expect the number as written");
+        AssertThat(std::string{ row.get("input") }).isEqualTo(std::string{ "a\\\"b" }, "Expect the string without its quotes");
+        AssertThat(std::string{ row.get("nested") }).isEqualTo(std::string{ "{\"input\": [1, 2]}" }, "Expect the object as written");
+        AssertThat(row.get("missing").empty()).isTrue("Expect a missing key to be empty");
+    });
+}
+
+register_scenario(H2OFastTests_Impact_Selection)
+{
+    add_test("ImpactIndex(affected)", []() {});
+
+    add_test("ImpactIndex(not affected)", []() {
+        AssertThat(false).isTrue("Expect the test not to be run");
+    });
+
+    add_test("ImpactIndex(prerequisite of an affected test)", []() {});
+
+    add_test("ImpactIndex(affected, with a prerequisite)", []() {}).dependsOn("ImpactIndex(prerequisite of an affected test)");
+
+    add_test("ImpactIndex(never recorded)", []() {});
+}
+
+register_scenario(H2OFastTests_Progress)
+{
+    add_test("ProgressFile(running test)", []() {
+        const auto report = H2OFastTests::read_progress(H2OFastTests::get_options().progress_file);
+        AssertThat(report.find("RUNNING [ProgressFile(running test)]") != std::string::npos).isTrue("Expect the running test to be published");
+    });
+
+    add_test("ProgressFile(scenario counters)", []() {
+        const auto report = H2OFastTests::read_progress(H2OFastTests::get_options().progress_file);
+        AssertThat(report.find("SCENARIO [H2OFastTests_Progress] 1/2, 0 failed") != std::string::npos).isTrue("Expect the first test to be counted");
+    });
+}
+
+register_scenario(H2OFastTests_Trace)
+{
+    add_test("TraceSpan(user span)", []() {
+        H2OFastTests::TraceSpan span{ "parse \"input\"" };
+        span.setArgs("\"size\":3");
+        AssertThat(span.isEnabled()).isTrue("Expect the trace to be recorded");
+    });
+}
+
+register_scenario(H2OFastTests_Phases)
+{
+    set_up([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    });
+
+    add_test("Test::getSetUpTimeMs()", []() {
+        scoped_timer("body");
+    });
+}
+
+register_scenario(H2OFastTests_VirtualClock)
+{
+    add_test("TestClock::sleep_for(virtual hour)", []() {
+        const auto start = H2OFastTests::TestClock::now();
+        const auto real_start = std::chrono::steady_clock::now();
+        H2OFastTests::TestClock::sleep_for(std::chrono::hours(1));
+        AssertThat(H2OFastTests::TestClock::now() - start == std::chrono::hours(1)).isTrue("Expect an hour of virtual time");
+        AssertThat(std::chrono::steady_clock::now() - real_start < std::chrono::seconds(1)).isTrue("Expect the sleep to be instant");
+    }).useVirtualClock();
+
+    add_test("TestClock::wait_for(auto advance across threads)", []() {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool ready = false;
+        H2OFastTests::TestThread producer([&]() {
+            H2OFastTests::TestClock::sleep_for(std::chrono::seconds(30));
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                ready = true;
+            }
+            condition.notify_all();
+        });
+        std::unique_lock<std::mutex> lock{ mutex };
+        AssertThat(H2OFastTests::TestClock::wait_for(condition, lock, std::chrono::seconds(10), [&ready]() { return ready; })).isFalse("Expect the first wait to time out");
+        AssertThat(H2OFastTests::TestClock::wait_for(condition, lock, std::chrono::minutes(1), [&ready]() { return ready; })).isTrue("Expect the producer to be ready");
+        AssertThat(H2OFastTests::TestClock::now().time_since_epoch() == std::chrono::seconds(30)).isTrue("Expect the time of the producer wake up");
+    }).useVirtualClock();
+
+    add_test("TestClock::advance(manual)", []() {
+        H2OFastTests::TestThread sleeper([]() {
+            H2OFastTests::TestClock::sleep_until(H2OFastTests::TestClock::time_point{ std::chrono::seconds(5) });
+        });
+        H2OFastTests::TestClock::advance(std::chrono::seconds(5));
+        sleeper.join();
+        AssertThat(H2OFastTests::TestClock::now().time_since_epoch() == std::chrono::seconds(5)).isTrue("Expect the time to be advanced");
+    }).useVirtualClock(false);
+}
+
+register_scenario(H2OFastTests_Dependencies_Base)
+{
+    add_test("Test::dependsOn(passed prerequisite)", []() {
+        AssertThat(true).isTrue("Expect the prerequisite to pass");
+    });
+
+    add_test("Test::dependsOn(run after its prerequisite)", []() {
+        const auto& tests = H2OFastTests_Dependencies_Base_registry_manager.getAllTests();
+        AssertThat(tests.front()->getStatus() == H2OFastTests::Test::Status::PASSED).isTrue("Expect the prerequisite to have run");
+    }).dependsOn("Test::dependsOn(passed prerequisite)");
+
+    skip_test("Test::dependsOn(skipped prerequisite)", []() {});
+
+    add_test("Test::dependsOn(skipped as its prerequisite didn't pass)", []() {
+        AssertThat(false).isTrue("Expect the test to be skipped");
+    }).dependsOn("Test::dependsOn(skipped prerequisite)");
+}
+
+register_scenario(H2OFastTests_Dependencies_Async)
+{
+    add_test("Test::dependsOn(async prerequisite)", []() {}).dependsOn("Test::dependsOn(async test)");
+
+    add_async_test("Test::dependsOn(async test)", []() {
+        return std::async(std::launch::async, []() {});
+    });
+}
+
+register_scenario(H2OFastTests_Dependencies_Dependent)
+{
+    depends_on("H2OFastTests_Dependencies_Base");
+
+    add_test("ScenarioRegistry::depends_on(run after its prerequisite)", []() {
+        AssertThat(H2OFastTests_Dependencies_Base_registry_manager.hasPassed()).isTrue("Expect the prerequisite scenario to have passed");
+    });
+}
+
+register_scenario(H2OFastTests_Dependencies_Unknown)
+{
+    depends_on("H2OFastTests_Dependencies_Missing");
+
+    add_test("ScenarioRegistry::depends_on(unknown prerequisite)", []() {
+        AssertThat(false).isTrue("Expect the test to be skipped");
+    });
+}
+
+register_scenario(H2OFastTests_Dependencies_Transitive)
+{
+    depends_on("H2OFastTests_Dependencies_Unknown");
+
+    add_test("ScenarioRegistry::depends_on(skipped prerequisite)", []() {
+        AssertThat(false).isTrue("Expect the test to be skipped");
+    });
+}
+
+register_scenario(H2OFastTests_Unowned)
+{
+    add_test("std::thread(assertion failed, several tests running)", []() {
+        // Stands for a test run concurrently : the failure can't be attributed
+        ++H2OFastTests::detail::running_tests_count();
+        const auto unowned = H2OFastTests::get_unowned_failures().size();
+        std::thread([]() {
+            AssertThat(1).isEqualTo(2, "Expect 1 == 2");
+        }).join();
+        --H2OFastTests::detail::running_tests_count();
+        auto& sink = H2OFastTests::detail::current_test()->getFailureSink();
+        AssertThat(sink.getFailures().empty()).isTrue("Expect the failure not to be attributed to this test");
+        AssertThat(H2OFastTests::get_unowned_failures().size()).isEqualTo(unowned + 1, "Expect the failure to be reported as unowned");
+    });
+}
+
+register_scenario(H2OFastTests_FailFast)
+{
+    add_test("CancellationToken::cancel()", []() {
+        H2OFastTests::get_cancellation_token().cancel();
+        AssertThat(H2OFastTests::is_cancelled()).isTrue("Expect the run to be cancelled");
+    });
+
+    add_test("CancellationToken(not run once cancelled)", []() {
+        AssertThat(false).isTrue("Expect the test to be cancelled");
+    });
+}
+
+register_scenario(H2OFastTests_FailFast_Async)
+{
+    add_async_test("CancellationToken::cancel(async)", []() {
+        return std::async(std::launch::async, []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            H2OFastTests::get_cancellation_token().cancel();
+        });
+    });
+
+    add_async_test("CancellationToken(async test running when cancelled)", []() {
+        return std::async(std::launch::async, []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        });
+    }, H2OFastTests::detail::Duration{ 10000 });
+}
+
+// Usage: Tests [baseline to compare with] [file to save the benchmarks samples to]
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        load_benchmark_baseline(argv[1]);
+    }
+
     register_observer(H2OFastTests_Tests, H2OFastTests::ConsoleIO_Observer);
     run_scenario(H2OFastTests_Tests);
     //print_result_verbose(H2OFastTests_Tests);
 
+    // Results as a struct-of-arrays table, the getters being views over it
+    const auto& results = H2OFastTests_Tests_registry_manager.getResults();
+    const auto slowest = results.sortByDuration(3);
+    const auto results_failures =
+        (results.size() == H2OFastTests_Tests_registry_manager.getAllTestsCount() ? 0 : 1) +
+        (results.select(H2OFastTests::Test::Status::PASSED).size() == H2OFastTests_Tests_registry_manager.getPassedTests().size() ? 0 : 1) +
+        (slowest.size() == 3 && results.getDuration(slowest[0]) >= results.getDuration(slowest[2]) &&
+            results.getDuration(slowest[2]) >= results.getDuration(results.sortByDuration().back()) ? 0 : 1) +
+        (results.getLabel(0) == results.getTest(0).getLabel(false) && results.getLabelId(0) == H2OFastTests::get_string_pool().intern(results.getLabel(0)) ? 0 : 1) +
+        (H2OFastTests::get_string_pool().get(results.getScenarioId(0)) == H2OFastTests_Tests_registry_manager.getName() ? 0 : 1);
+
+    H2OFastTests::get_options().collect_resource_usage = true;
+    pin_benchmarks(0);
+    register_observer(H2OFastTests_Benchmarks, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_Benchmarks);
+    print_result_verbose(H2OFastTests_Benchmarks);
+    run_scenario(H2OFastTests_Benchmarks_Threaded_Cold);
+    print_result_verbose(H2OFastTests_Benchmarks_Threaded_Cold);
+    const auto cold_failures = [&]() {
+        for (const auto& test : H2OFastTests_Benchmarks_registry_manager.getAllTests()) {
+            if (test->getLabel(false) == "Benchmark::first touch(n bytes)") {
+                if (static_cast<const H2OFastTests::ComplexityBenchmark&>(*test).getColdPoints().size() != 3)
+                    return 1;
+                continue;
+            }
+            if (test->getLabel(false) != "Benchmark::first touch(1MB)")
+                continue;
+            const auto& benchmark = static_cast<const H2OFastTests::Benchmark&>(*test);
+            const auto& timings = benchmark.getTimings();
+            const auto eviction = timings.find("cache eviction");
+            return benchmark.getColdSamples().size() == 10 && eviction != timings.end() && eviction->second.count == 10 ? 0 : 1;
+        }
+        return 1;
+    }() + (H2OFastTests_Benchmarks_Threaded_Cold_registry_manager.getWithErrorCount() == 1 ? 0 : 1);
+
+    auto& options = H2OFastTests::get_options();
+    options.shuffle = true;
+    options.repeat = 500;
+    options.jobs = 4;
+    run_scenario(H2OFastTests_Repeats);
+    print_result(H2OFastTests_Repeats);
+    options.shuffle = false;
+    options.repeat = 1;
+    options.jobs = 1;
+    const auto repeats_failures = repeated_stress_calls == 2 * 500 && repeated_async_calls == 500 &&
+        std::all_of(H2OFastTests_Repeats_registry_manager.getAllTests().begin(), H2OFastTests_Repeats_registry_manager.getAllTests().end(), [](const auto& test) {
+            return test->getIteration() == 499;
+        }) ? 0 : 1;
+
+    register_observer(H2OFastTests_Async, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_Async);
+    print_result(H2OFastTests_Async);
+    // The timeout bounds the run : the futures still running are left to detached threads
+    run_scenario(H2OFastTests_Async_Timeout);
+    print_result_verbose(H2OFastTests_Async_Timeout);
+    auto async_timeout_failures = H2OFastTests_Async_Timeout_registry_manager.getWithErrorCount() == 2 && !async_timed_out_body_done ? 0 : 1;
+    async_timed_out_release.set_value();
+    for (auto wait = 0; wait < 1000 && !async_timed_out_body_done; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    async_timeout_failures += async_timed_out_body_done ? 0 : 1;
+
+    // Replay of a corpus, then fuzzing from it : the mutation loop must find the failing byte
+    std::filesystem::remove_all(fuzz_corpus);
+    std::filesystem::create_directories(fuzz_corpus);
+    std::ofstream{ fuzz_corpus + "/a", std::ios::binary } << "abc";
+    std::ofstream{ fuzz_corpus + "/b", std::ios::binary } << "xy";
+    register_observer(H2OFastTests_Fuzz, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_Fuzz);
+    print_result_verbose(H2OFastTests_Fuzz);
+    options.fuzz = true;
+    options.fuzz_runs = 1000000;
+    run_scenario(H2OFastTests_Fuzzing);
+    print_result_verbose(H2OFastTests_Fuzzing);
+    run_scenario(H2OFastTests_Fuzzing_Flaky);
+    print_result_verbose(H2OFastTests_Fuzzing_Flaky);
+    options.fuzz = false;
+    const auto& fuzzing = static_cast<const H2OFastTests::FuzzTest&>(*H2OFastTests_Fuzzing_registry_manager.getAllTests().front());
+    const auto& flaky = static_cast<const H2OFastTests::FuzzTest&>(*H2OFastTests_Fuzzing_Flaky_registry_manager.getAllTests().front());
+    const auto fuzz_failures =
+        (H2OFastTests_Fuzz_registry_manager.hasPassed() && static_cast<const H2OFastTests::FuzzTest&>(*H2OFastTests_Fuzz_registry_manager.getAllTests().front()).getExecutions() == 3 ? 0 : 1) +
+        (H2OFastTests_Fuzzing_registry_manager.getFailedCount() == 1 && !fuzzing.getCrashPath().empty() && std::filesystem::file_size(fuzzing.getCrashPath()) == 1 ? 0 : 1) +
+        (flaky.getStatus() == H2OFastTests::Test::Status::FAILED && flaky.getFailureReason().find("(flaky)") != std::string::npos &&
+            std::filesystem::path{ flaky.getCrashPath() }.parent_path() == std::filesystem::temp_directory_path() / "h2oft" / "crashes" ? 0 : 1);
+    std::filesystem::remove_all(fuzz_corpus);
+    std::filesystem::remove(flaky.getCrashPath());
+
+    // Data-driven tests streamed from case files, on 2 threads
+    {
+        std::ofstream csv{ data_csv, std::ios::binary };
+        csv << "a,\"b\",sum\r\n";
+        for (int i = 0; i < 10000; ++i) {
+            csv << i << "," << 2 * i << "," << (i == 4 || i == 8999 ? 0 : 3 * i) << "\n";
+        }
+        std::ofstream{ data_jsonl, std::ios::binary } << "{\"input\": \"a\\\"b\", \"nested\": {\"input\": [1, 2]}, \"expected\": 3}\n\n"
+            << "{\"expected\":3 , \"input\":\"a\\\"b\",\"nested\":{\"input\": [1, 2]}}";
+    }
+    options.jobs = 2;
+    run_scenario(H2OFastTests_DataDriven);
+    options.jobs = 1;
+    print_result_verbose(H2OFastTests_DataDriven);
+    const auto& csv_test = static_cast<const H2OFastTests::DataDrivenTest&>(*H2OFastTests_DataDriven_registry_manager.getAllTests().front());
+    const auto& csv_reason = csv_test.getFailureReason();
+    const auto& first_row_reason = H2OFastTests_DataDriven_registry_manager.getAllTests()[1]->getFailureReason();
+    const auto data_failures =
+        (csv_test.getStatus() == H2OFastTests::Test::Status::FAILED && csv_test.getRows() == 10000 && csv_test.getFailedRows() == 2 &&
+            csv_reason.find(data_csv + ":6] 4,8,0") != std::string::npos && csv_reason.find(data_csv + ":9001] 8999,17998,0") != std::string::npos ? 0 : 1) +
+        (first_row_reason.find(data_csv + ":6] 4,8,0") != std::string::npos && first_row_reason.find(":9001]") == std::string::npos &&
+            first_row_reason.find("1 more failing rows") != std::string::npos ? 0 : 1) +
+        (H2OFastTests_DataDriven_registry_manager.getPassedCount() == 1 &&
+            static_cast<const H2OFastTests::DataDrivenTest&>(*H2OFastTests_DataDriven_registry_manager.getAllTests().back()).getRows() == 2 ? 0 : 1);
+    std::filesystem::remove(data_csv);
+    std::filesystem::remove(data_jsonl);
+
+    // Test impact analysis : only run the tests affected by a change (the recording is tested by ImpactTests)
+    options.impact_index = (std::filesystem::temp_directory_path() / "h2oft_impact.idx").string();
+    std::filesystem::remove(options.impact_index);
+    auto& impact_index = H2OFastTests::detail::get_impact_index();
+    size_t impact_failures = 0;
+    impact_index.open(options.impact_index);
+    impact_index.record("H2OFastTests_Impact_Selection", "ImpactIndex(affected)", { { "impact_target()", "src/impact.cpp" } });
+    impact_index.record("H2OFastTests_Impact_Selection", "ImpactIndex(not affected)", { { "other()", "src/other.cpp" } });
+    impact_index.record("H2OFastTests_Impact_Selection", "ImpactIndex(prerequisite of an affected test)", { { "other()", "src/other.cpp" } });
+    impact_index.record("H2OFastTests_Impact_Selection", "ImpactIndex(affected, with a prerequisite)", { { "render()", "src/impact.cpp" } });
+    impact_index.save();
+    options.impact_select = true;
+    options.impact_changes = { "src/impact.cpp" };
+    run_scenario(H2OFastTests_Impact_Selection);
+    print_result_verbose(H2OFastTests_Impact_Selection);
+    options.impact_select = false;
+    options.impact_changes.clear();
+    impact_failures += H2OFastTests_Impact_Selection_registry_manager.getPassedCount() == 4 && H2OFastTests_Impact_Selection_registry_manager.getFailedCount() == 0 ? 0 : 1;
+    std::filesystem::remove(options.impact_index);
+    // The index is a journal : each flush only appends the recorded tests, the last line of a test wins when loading
+    {
+        H2OFastTests::detail::ImpactIndex journal;
+        journal.open(options.impact_index);
+        journal.record("Journal", "test", { { "first()", "src/first.cpp" } });
+        journal.record("Journal", "other", { { "other()", "src/other.cpp" } });
+        impact_failures += journal.flush() ? 0 : 1;
+        const auto size = std::filesystem::file_size(options.impact_index);
+        journal.record("Journal", "test", { { "second()", "src/second.cpp" } });
+        impact_failures += journal.flush() ? 0 : 1;
+        impact_failures += std::filesystem::file_size(options.impact_index) - size == std::string("F second()\tsrc/second.cpp\nT Journal\ttest\t2\n").size() ? 0 : 1;
+        H2OFastTests::detail::ImpactIndex reloaded;
+        reloaded.open(options.impact_index);
+        impact_failures += reloaded.getTestsCount() == 2 && reloaded.isAffected("Journal", "test", { "src/second.cpp" }) && !reloaded.isAffected("Journal", "test", { "src/first.cpp" }) ? 0 : 1;
+        // Compacted on load once the replaced lines outnumber the tests
+        for (int run = 0; run < 20; ++run) {
+            reloaded.record("Journal", "test", { { "second()", "src/second.cpp" } });
+            reloaded.flush();
+        }
+        const auto journal_size = std::filesystem::file_size(options.impact_index);
+        H2OFastTests::detail::ImpactIndex compacted;
+        compacted.open(options.impact_index);
+        impact_failures += std::filesystem::file_size(options.impact_index) < journal_size && !compacted.isAffected("Journal", "other", { "src/first.cpp" }) && compacted.isAffected("Journal", "other", { "other()" }) ? 0 : 1;
+        compacted.record("Journal", "other", { { "third()", "src/third.cpp" } });
+        compacted.flush();
+        H2OFastTests::detail::ImpactIndex appended;
+        appended.open(options.impact_index);
+        impact_failures += appended.isAffected("Journal", "other", { "src/third.cpp" }) && appended.isAffected("Journal", "test", { "src/second.cpp" }) && !appended.isAffected("Journal", "test", { "src/third.cpp" }) ? 0 : 1;
+    }
+    std::filesystem::remove(options.impact_index);
+    options.impact_index.clear();
+
+    // Live progress published in a memory-mapped file
+    size_t progress_failures = 0;
+#if H2OFT_OS_LINUX
+    options.progress_file = (std::filesystem::temp_directory_path() / "h2oft_progress").string();
+    run_scenario(H2OFastTests_Progress);
+    print_result(H2OFastTests_Progress);
+    const auto progress = H2OFastTests::read_progress(options.progress_file);
+    std::cout << progress;
+    progress_failures = H2OFastTests_Progress_registry_manager.getPassedCount() == 2 && progress.find(": 2/2 tests, 2 passed") != std::string::npos ? 0 : 1;
+    {
+        // A run killed while publishing the name of its scenario
+        std::fstream file{ options.progress_file, std::ios::in | std::ios::out | std::ios::binary };
+        const uint64_t odd_sequence = 1;
+        file.seekp(offsetof(H2OFastTests::detail::ProgressFile, scenarios) + offsetof(H2OFastTests::detail::ProgressFile::Scenario, sequence));
+        file.write(reinterpret_cast<const char*>(&odd_sequence), sizeof(odd_sequence));
+    }
+    progress_failures += H2OFastTests::read_progress(options.progress_file).find("SCENARIO [<torn>]") != std::string::npos ? 0 : 1;
+    std::filesystem::remove(options.progress_file);
+    options.progress_file.clear();
+#endif
+
+    // Set up, body and tear down timed apart
+    run_scenario(H2OFastTests_Phases);
+    print_result_verbose(H2OFastTests_Phases);
+    const auto& phases_test = *H2OFastTests_Phases_registry_manager.getAllTests().front();
+    const auto phases_failures = H2OFastTests_Phases_registry_manager.getPassedCount() == 1 && phases_test.getSetUpTimeMs().count() >= 2. &&
+        phases_test.getExecTimeMs() < phases_test.getSetUpTimeMs() && H2OFastTests_Phases_registry_manager.getAllTestsSetUpTimeMs() == phases_test.getSetUpTimeMs() &&
+        H2OFastTests_Phases_registry_manager.getAllTestsTimings()["body"].count == 1 ? 0 : 1;
+
+    // Sleeps and timed waits in virtual time
+    run_scenario(H2OFastTests_VirtualClock);
+    print_result(H2OFastTests_VirtualClock);
+    const auto virtual_clock_failures = H2OFastTests_VirtualClock_registry_manager.getPassedCount() == 3 &&
+        H2OFastTests_VirtualClock_registry_manager.getAllTestsExecTimeMs().count() < 1000. ? 0 : 1;
+
+    // Timeline of the run, in the Chrome trace-event format
+    options.trace = true;
+    run_scenario(H2OFastTests_Trace);
+    options.trace = false;
+    print_result(H2OFastTests_Trace);
+    const auto trace_path = (std::filesystem::temp_directory_path() / "h2oft_trace.json").string();
+    save_trace(trace_path);
+    std::ifstream trace_file(trace_path);
+    const std::string trace{ std::istreambuf_iterator<char>(trace_file), std::istreambuf_iterator<char>() };
+    trace_file.close();
+    const auto trace_failures = H2OFastTests_Trace_registry_manager.getPassedCount() == 1 &&
+        trace.find("{\"name\":\"H2OFastTests_Trace\",\"cat\":\"scenario\"") != std::string::npos &&
+        trace.find("{\"name\":\"set_up\",\"cat\":\"fixture\"") != std::string::npos &&
+        trace.find("\"cat\":\"test\"") != std::string::npos && trace.find("\"status\":\"PASSED\"") != std::string::npos &&
+        trace.find("{\"name\":\"tear_down\",\"cat\":\"fixture\"") != std::string::npos &&
+        trace.find("{\"name\":\"parse \\\"input\\\"\",\"cat\":\"user\"") != std::string::npos ? 0 : 1;
+    std::filesystem::remove(trace_path);
+
+    // A failure that can't be attributed to a test still fails its scenario
+    run_scenario(H2OFastTests_Unowned);
+    print_result_verbose(H2OFastTests_Unowned);
+    const auto unowned_failures = H2OFastTests_Unowned_registry_manager.getPassedCount() == 1 && !H2OFastTests_Unowned_registry_manager.hasPassed() &&
+        H2OFastTests_Unowned_registry_manager.getUnownedFailures().size() == 1 ? 0 : 1;
+    H2OFastTests::get_cancellation_token().reset();
+
+    register_observer(H2OFastTests_FailFast, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_FailFast);
+    print_result_verbose(H2OFastTests_FailFast);
+    const auto& not_run = *H2OFastTests_FailFast_registry_manager.getAllTests().back();
+    auto fail_fast_failures = H2OFastTests_FailFast_registry_manager.getCancelledCount() == 1 &&
+        not_run.getSkippedReason() == "Run cancelled: cancelled by the user" ? 0 : 1;
+    H2OFastTests::get_cancellation_token().reset();
+    // Cancelled while the second async test is in flight : dropped without waiting for its timeout
+    register_observer(H2OFastTests_FailFast_Async, H2OFastTests::ConsoleIO_Observer);
+    run_scenario(H2OFastTests_FailFast_Async);
+    print_result_verbose(H2OFastTests_FailFast_Async);
+    const auto& in_flight = *H2OFastTests_FailFast_Async_registry_manager.getAllTests().back();
+    fail_fast_failures += H2OFastTests_FailFast_Async_registry_manager.getCancelledCount() == 1 &&
+        in_flight.getSkippedReason() == "Run cancelled while running: cancelled by the user" ? 0 : 1;
+    H2OFastTests::get_cancellation_token().reset();
+
+    // The scenarios not run yet, in dependency order
+    run_all_scenarios();
+    print_result_verbose(H2OFastTests_Dependencies_Base);
+    print_result(H2OFastTests_Dependencies_Dependent);
+    print_result_verbose(H2OFastTests_Dependencies_Unknown);
+    print_result_verbose(H2OFastTests_Dependencies_Transitive);
+    print_result_verbose(H2OFastTests_Dependencies_Async);
+    const auto dependencies_failures =
+        (H2OFastTests_Dependencies_Async_registry_manager.getWithErrorCount() == 1 && H2OFastTests_Dependencies_Async_registry_manager.getPassedCount() == 1 ? 0 : 1) +
+        (H2OFastTests_Dependencies_Base_registry_manager.getSkippedCount() == 2 ? 0 : 1) +
+        (H2OFastTests_Dependencies_Dependent_registry_manager.getPassedCount() == 1 ? 0 : 1) +
+        (H2OFastTests_Dependencies_Unknown_registry_manager.getSkippedCount() == 1 ? 0 : 1) +
+        (H2OFastTests_Dependencies_Transitive_registry_manager.getSkippedCount() == 1 ? 0 : 1);
+
+    if (argc > 2) {
+        save_benchmark_baseline(argv[2]);
+    }
+
+    const auto failures =
+        H2OFastTests_Tests_registry_manager.getFailedCount() + H2OFastTests_Tests_registry_manager.getWithErrorCount() +
+        H2OFastTests_Benchmarks_registry_manager.getFailedCount() + H2OFastTests_Benchmarks_registry_manager.getWithErrorCount() +
+        H2OFastTests_Repeats_registry_manager.getFailedCount() + H2OFastTests_Repeats_registry_manager.getWithErrorCount() +
+        H2OFastTests_Async_registry_manager.getFailedCount() + H2OFastTests_Async_registry_manager.getWithErrorCount() +
+        results_failures + async_timeout_failures + cold_failures + fuzz_failures + data_failures + impact_failures + progress_failures + phases_failures + virtual_clock_failures + trace_failures + dependencies_failures + fail_fast_failures + unowned_failures + repeats_failures;
+
     std::cout << "Press enter to continue...";
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file